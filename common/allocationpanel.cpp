@@ -0,0 +1,87 @@
+#include "allocationpanel.h"
+#include "allocationstats.h"
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QShortcut>
+#include <QTimer>
+
+AllocationPanel::AllocationPanel(QWidget *parent)
+    : QWidget(parent, Qt::Window),
+    _table(new QTableWidget(this))
+{
+    setWindowTitle("Память по этапам");
+    resize(900, 400);
+
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    _table->horizontalHeader()->setStretchLastSection(true);
+    _table->verticalHeader()->setVisible(false);
+    _table->setColumnCount(6);
+    _table->setHorizontalHeaderLabels(QStringList() << "Этап"
+                                                    << "Входы"
+                                                    << "Выделения"
+                                                    << "Байт"
+                                                    << "Пиковый RSS, КиБ"
+                                                    << "Рост RSS, КиБ");
+
+    auto resetButton = new QPushButton("Сбросить", this);
+    connect(resetButton, &QPushButton::clicked, this, [this]()
+    {
+        AllocationStats::reset();
+        refresh();
+    });
+
+    auto timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, [this]()
+    {
+        if (isVisible())
+            refresh();
+    });
+    timer->start(1000);
+
+    auto layout = new QVBoxLayout(this);
+    layout->addWidget(_table);
+    layout->addWidget(resetButton, 0, Qt::AlignRight);
+    setLayout(layout);
+}
+
+void AllocationPanel::install(QWidget *window)
+{
+    if (!AllocationStats::isEnabled())
+        return;
+
+    auto panel = new AllocationPanel(window);
+    auto shortcut = new QShortcut(QKeySequence(Qt::Key_F12), window);
+    connect(shortcut, &QShortcut::activated, panel, [panel]()
+    {
+        panel->refresh();
+        panel->show();
+        panel->raise();
+    });
+}
+
+void AllocationPanel::refresh()
+{
+    auto stages = AllocationStats::report();
+    _table->setRowCount(stages.size());
+
+    for (int row = 0; row < stages.size(); row++)
+    {
+        const auto &stage = stages[row];
+        QStringList values = {stage.name,
+                              QString::number(stage.calls),
+                              QString::number(stage.allocations),
+                              QString::number(stage.bytes),
+                              QString::number(stage.peakRssKb),
+                              QString::number(stage.rssGrowthKb)};
+
+        for (int column = 0; column < values.size(); column++)
+        {
+            auto item = new QTableWidgetItem(values[column]);
+            item->setTextAlignment(column == 0 ? Qt::AlignLeft | Qt::AlignVCenter : Qt::AlignRight | Qt::AlignVCenter);
+            _table->setItem(row, column, item);
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef ALLOCATIONPANEL_H
+#define ALLOCATIONPANEL_H
+
+#include <QWidget>
+
+class QTableWidget;
+
+/**
+ * @brief Отладочная панель учета памяти по этапам анализа.
+ * @details Открывается клавишей F12 в окне, к которому подключена,
+ * и обновляет таблицу AllocationStats раз в секунду, пока видна.
+ */
+class AllocationPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit AllocationPanel(QWidget *parent = nullptr);
+
+    /// Подключает панель к окну, если учет памяти включен.
+    static void install(QWidget *window);
+
+    void refresh();
+
+private:
+    QTableWidget *_table;
+};
+
+#endif // ALLOCATIONPANEL_H
@@ -0,0 +1,283 @@
+#include "allocationstats.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace AllocationStats
+{
+struct Stage
+{
+    std::atomic<const char *> name{nullptr};
+    std::atomic<quint64> calls{0};
+    std::atomic<quint64> allocations{0};
+    std::atomic<quint64> bytes{0};
+    std::atomic<qint64> peakRssKb{0};
+    std::atomic<qint64> rssGrowthKb{0};
+};
+}
+
+namespace
+{
+using AllocationStats::Stage;
+
+constexpr int maxStages = 128;
+
+/// Таблица этапов фиксированного размера: счетчик выделения не должен сам выделять память.
+Stage stages[maxStages];
+std::atomic<int> stageCount{0};
+std::mutex stagesMutex;
+
+Stage outsideStage;     ///< Выделения вне этапов
+Stage overflowStage;    ///< Этапы сверх maxStages
+
+thread_local Stage *currentStage = nullptr;
+
+Stage *findStage(const char *name)
+{
+    int count = stageCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        auto stageName = stages[i].name.load(std::memory_order_relaxed);
+        if (stageName == name || std::strcmp(stageName, name) == 0)
+            return &stages[i];
+    }
+    return nullptr;
+}
+
+Stage *stageFor(const char *name)
+{
+    if (auto stage = findStage(name))
+        return stage;
+
+    std::lock_guard<std::mutex> lock(stagesMutex);
+    if (auto stage = findStage(name))
+        return stage;
+
+    int count = stageCount.load(std::memory_order_relaxed);
+    if (count == maxStages)
+        return &overflowStage;
+
+    stages[count].name.store(name, std::memory_order_relaxed);
+    stageCount.store(count + 1, std::memory_order_release);
+    return &stages[count];
+}
+
+inline void countAllocation(std::size_t size)
+{
+    if (!AllocationStats::isEnabled())
+        return;
+
+    auto stage = currentStage ? currentStage : &outsideStage;
+    stage->allocations.fetch_add(1, std::memory_order_relaxed);
+    stage->bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+AllocationStats::StageReport snapshot(const Stage &stage, const char *name)
+{
+    return {QString::fromUtf8(name),
+            stage.calls.load(std::memory_order_relaxed),
+            stage.allocations.load(std::memory_order_relaxed),
+            stage.bytes.load(std::memory_order_relaxed),
+            stage.peakRssKb.load(std::memory_order_relaxed),
+            stage.rssGrowthKb.load(std::memory_order_relaxed)};
+}
+
+void resetStage(Stage &stage)
+{
+    stage.calls.store(0, std::memory_order_relaxed);
+    stage.allocations.store(0, std::memory_order_relaxed);
+    stage.bytes.store(0, std::memory_order_relaxed);
+    stage.peakRssKb.store(0, std::memory_order_relaxed);
+    stage.rssGrowthKb.store(0, std::memory_order_relaxed);
+}
+}
+
+#if !defined(DATAANALYS_ALLOCATION_HOOKS)
+// Функции выделения не подменяются, счетчики выделений остаются нулевыми.
+#elif defined(__GLIBC__)
+// В glibc функции выделения подменяются определением в исполняемом файле,
+// поэтому учитываются и контейнеры Qt, которые выделяют память через malloc.
+// Выделения с выравниванием (memalign, posix_memalign) не учитываются.
+extern "C"
+{
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *pointer, std::size_t size);
+
+void *malloc(std::size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) noexcept
+{
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, std::size_t size) noexcept
+{
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+}
+#else
+// На остальных платформах учитываются только выделения через operator new.
+void *operator new(std::size_t size)
+{
+    countAllocation(size);
+    if (auto pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    countAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+#endif
+
+namespace AllocationStats
+{
+std::atomic<bool> enabled{false};
+
+void setEnabled(bool value)
+{
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+void enableFromEnvironment()
+{
+    auto value = qgetenv("DATAANALYS_ALLOC_STATS");
+    if (!value.isEmpty() && value != "0")
+        setEnabled(true);
+}
+
+qint64 peakRssKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(Q_OS_MACOS)
+    return usage.ru_maxrss / 1024;  // в байтах
+#else
+    return usage.ru_maxrss;         // в КиБ
+#endif
+#endif
+}
+
+void StageScope::enter(const char *name)
+{
+    _stage = stageFor(name);
+    _stage->calls.fetch_add(1, std::memory_order_relaxed);
+    _previous = currentStage;
+    currentStage = _stage;
+    _startPeakKb = peakRssKb();
+}
+
+void StageScope::leave()
+{
+    auto peak = peakRssKb();
+    _stage->rssGrowthKb.fetch_add(peak - _startPeakKb, std::memory_order_relaxed);
+
+    auto stored = _stage->peakRssKb.load(std::memory_order_relaxed);
+    while (stored < peak && !_stage->peakRssKb.compare_exchange_weak(stored, peak, std::memory_order_relaxed))
+    {
+    }
+    currentStage = _previous;
+}
+
+QVector<StageReport> report()
+{
+    QVector<StageReport> result;
+    int count = stageCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+        result.append(snapshot(stages[i], stages[i].name.load(std::memory_order_relaxed)));
+
+    if (overflowStage.calls.load(std::memory_order_relaxed) > 0)
+        result.append(snapshot(overflowStage, "(прочие этапы)"));
+    result.append(snapshot(outsideStage, "(вне этапов)"));
+
+    std::stable_sort(result.begin(), result.end(), [](const StageReport &a, const StageReport &b)
+    {
+        return a.bytes > b.bytes;
+    });
+    return result;
+}
+
+QString formatReport()
+{
+    QString out = "stage\tcalls\tallocations\tbytes\tpeak_rss_kb\trss_growth_kb\n";
+    for (const auto &stage : report())
+    {
+        out += stage.name + '\t' + QString::number(stage.calls) + '\t'
+               + QString::number(stage.allocations) + '\t' + QString::number(stage.bytes) + '\t'
+               + QString::number(stage.peakRssKb) + '\t' + QString::number(stage.rssGrowthKb) + '\n';
+    }
+    return out;
+}
+
+quint64 totalAllocations()
+{
+    quint64 total = outsideStage.allocations.load(std::memory_order_relaxed)
+                    + overflowStage.allocations.load(std::memory_order_relaxed);
+    int count = stageCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+        total += stages[i].allocations.load(std::memory_order_relaxed);
+    return total;
+}
+
+bool countsAllocations()
+{
+#if defined(DATAANALYS_ALLOCATION_HOOKS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void reset()
+{
+    int count = stageCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++)
+        resetStage(stages[i]);
+    resetStage(overflowStage);
+    resetStage(outsideStage);
+}
+}
@@ -0,0 +1,99 @@
+#ifndef ALLOCATIONSTATS_H
+#define ALLOCATIONSTATS_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+/**
+ * @brief Учет выделений памяти по этапам анализа.
+ * @details Этапы задаются интервалами трассировки TRACE_SPAN. Число выделений
+ * и их объем относятся к самому вложенному открытому этапу потока, рост пикового
+ * RSS процесса — ко всем открытым этапам. Учет включается переменной окружения
+ * DATAANALYS_ALLOC_STATS=1; при выключенном учете счетчик выделения стоит
+ * одну атомарную загрузку.
+ * Выделения считаются только в сборке с опцией CMake DATAANALYS_ALLOCATION_HOOKS,
+ * которая подменяет функции выделения памяти; без нее учитывается только RSS.
+ */
+namespace AllocationStats
+{
+extern std::atomic<bool> enabled;
+
+inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+void setEnabled(bool value);
+
+/// Включает учет, если задана переменная DATAANALYS_ALLOC_STATS.
+void enableFromEnvironment();
+
+struct StageReport
+{
+    QString name;
+    quint64 calls;          ///< Число входов в этап
+    quint64 allocations;    ///< Число выделений памяти
+    quint64 bytes;          ///< Запрошенный объем, байт
+    qint64 peakRssKb;       ///< Пиковый RSS процесса при выходе из этапа, КиБ
+    qint64 rssGrowthKb;     ///< Суммарный рост пикового RSS внутри этапа, КиБ
+};
+
+/// Снимок счетчиков, упорядоченный по убыванию объема.
+QVector<StageReport> report();
+
+/// Снимок счетчиков в виде таблицы с табуляциями.
+QString formatReport();
+
+/// Обнуляет счетчики всех этапов.
+void reset();
+
+/// Число выделений по всем этапам с последнего обнуления.
+quint64 totalAllocations();
+
+/// Подменены ли функции выделения (DATAANALYS_ALLOCATION_HOOKS), иначе число выделений всегда нулевое.
+bool countsAllocations();
+
+/// Пиковый RSS процесса, КиБ.
+qint64 peakRssKb();
+
+struct Stage;
+
+/// Этап от создания до разрушения объекта.
+class StageScope
+{
+public:
+    /// @param name Строковый литерал, указатель сохраняется без копирования.
+    explicit StageScope(const char *name) :
+        _active(isEnabled())
+    {
+        if (_active)
+            enter(name);
+    }
+
+    ~StageScope()
+    {
+        close();
+    }
+
+    /// Выходит из этапа до разрушения объекта.
+    void close()
+    {
+        if (_active)
+        {
+            leave();
+            _active = false;
+        }
+    }
+
+    StageScope(const StageScope &) = delete;
+    StageScope &operator=(const StageScope &) = delete;
+
+private:
+    void enter(const char *name);
+    void leave();
+
+    bool _active;
+    Stage *_stage = nullptr;
+    Stage *_previous = nullptr;
+    qint64 _startPeakKb = 0;
+};
+}
+
+#endif // ALLOCATIONSTATS_H
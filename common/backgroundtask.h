@@ -0,0 +1,26 @@
+#ifndef BACKGROUNDTASK_H
+#define BACKGROUNDTASK_H
+
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+/**
+ * Выполняет task в пуле потоков и передает результат в done в потоке context.
+ * task не должен обращаться к виджетам. Если context удален раньше,
+ * результат отбрасывается.
+ */
+template <typename Task, typename Done>
+void runInBackground(QObject *context, Task task, Done done)
+{
+    using Result = decltype(task());
+
+    auto watcher = new QFutureWatcher<Result>(context);
+    QObject::connect(watcher, &QFutureWatcher<Result>::finished, context, [watcher, done]()
+    {
+        done(watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(task));
+}
+
+#endif // BACKGROUNDTASK_H
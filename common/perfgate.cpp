@@ -0,0 +1,176 @@
+#include "perfgate.h"
+#include "allocationstats.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+constexpr int defaultRepeats = 7;
+constexpr double defaultTimeTolerance = 0.25;
+constexpr double defaultAllocationTolerance = 0.05;
+
+QString argumentValue(int argc, char *argv[], const QString &key)
+{
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (QString(argv[i]) == key)
+            return QString::fromLocal8Bit(argv[i + 1]);
+    }
+    return {};
+}
+
+template<typename T>
+T median(QVector<T> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+QJsonObject readBaseline(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+bool writeBaseline(const QString &filePath, const QVector<PerfGate::Measurement> &measurements)
+{
+    auto baseline = readBaseline(filePath);
+    if (!baseline.contains("timeTolerance"))
+        baseline["timeTolerance"] = defaultTimeTolerance;
+    if (!baseline.contains("allocationTolerance"))
+        baseline["allocationTolerance"] = defaultAllocationTolerance;
+
+    QJsonObject scenarios;
+    for (const auto &measurement : measurements)
+    {
+        QJsonObject entry;
+        entry["medianMs"] = measurement.medianMs;
+        if (AllocationStats::countsAllocations())
+            entry["allocations"] = static_cast<double>(measurement.allocations);
+        scenarios[measurement.name] = entry;
+    }
+    baseline["scenarios"] = scenarios;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Failed to open file for writing:" << filePath << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(baseline).toJson());
+    return true;
+}
+
+double tolerance(int argc, char *argv[], const QString &key, const QJsonObject &baseline,
+                 const QString &field, double defaultValue)
+{
+    auto value = argumentValue(argc, argv, key);
+    if (!value.isEmpty())
+        return value.toDouble();
+    return baseline.value(field).toDouble(defaultValue);
+}
+}
+
+namespace PerfGate
+{
+bool isRequested(int argc, char *argv[])
+{
+    return !argumentValue(argc, argv, "--perf-gate").isEmpty()
+           || !argumentValue(argc, argv, "--perf-baseline").isEmpty();
+}
+
+Measurement measure(const Scenario &scenario, int repeats)
+{
+    scenario.run();
+
+    QVector<double> times;
+    QVector<quint64> allocations;
+    for (int i = 0; i < repeats; i++)
+    {
+        auto allocationsBefore = AllocationStats::totalAllocations();
+        auto start = std::chrono::steady_clock::now();
+        scenario.run();
+        auto end = std::chrono::steady_clock::now();
+
+        times.append(std::chrono::duration<double, std::milli>(end - start).count());
+        allocations.append(AllocationStats::totalAllocations() - allocationsBefore);
+    }
+    return {scenario.name, median(times), median(allocations)};
+}
+
+int run(int argc, char *argv[], const QVector<Scenario> &scenarios)
+{
+    auto repeatsValue = argumentValue(argc, argv, "--repeats");
+    int repeats = repeatsValue.isEmpty() ? defaultRepeats : std::max(1, repeatsValue.toInt());
+
+    AllocationStats::setEnabled(true);
+    QVector<Measurement> measurements;
+    for (const auto &scenario : scenarios)
+        measurements.append(measure(scenario, repeats));
+
+    auto baselinePath = argumentValue(argc, argv, "--perf-baseline");
+    if (!baselinePath.isEmpty())
+        return writeBaseline(baselinePath, measurements) ? 0 : 1;
+
+    baselinePath = argumentValue(argc, argv, "--perf-gate");
+    auto baseline = readBaseline(baselinePath);
+    if (baseline.isEmpty())
+    {
+        qDebug() << "Failed to read baseline:" << baselinePath;
+        return 1;
+    }
+
+    double timeTolerance = tolerance(argc, argv, "--tolerance", baseline, "timeTolerance", defaultTimeTolerance);
+    double allocationTolerance = tolerance(argc, argv, "--alloc-tolerance", baseline, "allocationTolerance",
+                                           defaultAllocationTolerance);
+    auto expected = baseline.value("scenarios").toObject();
+
+    QTextStream out(stdout);
+    out << "baseline machine: " << baseline.value("machine").toString() << '\n';
+    out << "scenario\tmedian_ms\tbaseline_ms\tallocations\tbaseline_allocations\tresult\n";
+
+    bool passed = true;
+    bool complete = true;
+    for (const auto &measurement : measurements)
+    {
+        QString result = "ok";
+        double baselineMs = 0;
+        double baselineAllocations = 0;
+
+        if (!expected.contains(measurement.name))
+        {
+            // Новый сценарий должен попасть в базу через --perf-baseline на эталонной машине.
+            result = "no baseline";
+            complete = false;
+        }
+        else
+        {
+            auto entry = expected.value(measurement.name).toObject();
+            baselineMs = entry.value("medianMs").toDouble();
+            baselineAllocations = entry.value("allocations").toDouble();
+
+            // Выделения сравниваются, только если они считаются и в замере, и в базе.
+            const bool compareAllocations = AllocationStats::countsAllocations() && entry.contains("allocations");
+            if (measurement.medianMs > baselineMs * (1.0 + timeTolerance))
+                result = "time regression";
+            else if (compareAllocations && measurement.allocations > baselineAllocations * (1.0 + allocationTolerance))
+                result = "allocation regression";
+            passed = passed && result == "ok";
+        }
+
+        out << measurement.name << '\t' << measurement.medianMs << '\t' << baselineMs << '\t'
+            << measurement.allocations << '\t' << baselineAllocations << '\t' << result << '\n';
+    }
+    if (!passed)
+        return 1;
+    return complete ? 0 : skippedExitCode;
+}
+}
@@ -0,0 +1,55 @@
+#ifndef PERFGATE_H
+#define PERFGATE_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief Проверка производительности сквозных сценариев по сохраненной базе.
+ * @details Каждый сценарий прогоняется несколько раз, медиана времени и числа
+ * выделений памяти сравниваются с базой в JSON. Превышение базы больше допуска
+ * считается регрессией. Выделения считаются только в сборке с опцией
+ * DATAANALYS_ALLOCATION_HOOKS, без нее они не записываются и не сравниваются.
+ * Сценарий без замера в базе не считается ни пройденным, ни проваленным:
+ * программа завершается с кодом skippedExitCode, который CTest показывает как пропуск.
+ *
+ * Ключи командной строки:
+ * --perf-gate <файл>      сравнить с базой, код завершения 1 при регрессии;
+ * --perf-baseline <файл>  записать замеры как новую базу;
+ * --repeats <N>           число замеряемых прогонов, по умолчанию 7;
+ * --tolerance <доля>      допуск по времени вместо указанного в базе;
+ * --alloc-tolerance <доля> допуск по выделениям вместо указанного в базе.
+ */
+namespace PerfGate
+{
+/// Код завершения, если хотя бы для одного сценария в базе нет замера, а регрессий нет.
+constexpr int skippedExitCode = 77;
+
+struct Scenario
+{
+    QString name;
+    std::function<void()> run;
+};
+
+struct Measurement
+{
+    QString name;
+    double medianMs;        ///< Медиана времени прогона, мс
+    quint64 allocations;    ///< Медиана числа выделений за прогон
+};
+
+/// Запущена ли программа с ключом --perf-gate или --perf-baseline.
+bool isRequested(int argc, char *argv[]);
+
+/// Прогоняет сценарий один раз для прогрева и repeats раз для замера.
+Measurement measure(const Scenario &scenario, int repeats);
+
+/**
+ * Замеряет сценарии и сравнивает их с базой или записывает новую базу.
+ * @return Код завершения программы.
+ */
+int run(int argc, char *argv[], const QVector<Scenario> &scenarios);
+}
+
+#endif // PERFGATE_H
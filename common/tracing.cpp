@@ -0,0 +1,136 @@
+#include "tracing.h"
+
+#include <QDebug>
+#include <QFile>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+struct Event
+{
+    const char *name;
+    qint64 start;   ///< мкс от запуска программы
+    qint64 end;
+};
+
+struct ThreadBuffer
+{
+    int threadId;
+    std::mutex mutex;   ///< Захватывается владельцем при записи, берется свободным
+    std::vector<Event> events;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    QString exitFile;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+const auto startTime = std::chrono::steady_clock::now();
+
+/// Буфер текущего потока; регистрируется один раз и переживает поток.
+ThreadBuffer &threadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer = []()
+    {
+        auto &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto created = std::make_shared<ThreadBuffer>();
+        created->threadId = static_cast<int>(reg.buffers.size()) + 1;
+        created->events.reserve(1024);
+        reg.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void appendEscaped(QByteArray &out, const char *text)
+{
+    for (auto c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            out += '\\';
+        out += *c;
+    }
+}
+
+void writeAtExit()
+{
+    Tracing::writeChromeTrace(registry().exitFile);
+}
+}
+
+namespace Tracing
+{
+std::atomic<bool> enabled{false};
+
+void setEnabled(bool value)
+{
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+void enableFromEnvironment()
+{
+    auto filePath = qgetenv("DATAANALYS_TRACE");
+    if (filePath.isEmpty())
+        return;
+
+    registry().exitFile = QString::fromLocal8Bit(filePath);
+    setEnabled(true);
+    std::atexit(writeAtExit);
+}
+
+qint64 Span::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Span::record(const char *name, qint64 start, qint64 end)
+{
+    auto &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({name, start, end});
+}
+
+bool writeChromeTrace(const QString &filePath)
+{
+    QByteArray out = "{\"traceEvents\":[";
+    bool first = true;
+
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &buffer : reg.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const auto &event : buffer->events)
+        {
+            out += first ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+            appendEscaped(out, event.name);
+            out += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number(buffer->threadId)
+                   + ",\"ts\":" + QByteArray::number(event.start)
+                   + ",\"dur\":" + QByteArray::number(event.end - event.start) + "}";
+            first = false;
+        }
+    }
+    out += "\n]}\n";
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Failed to open file for writing:" << filePath << file.errorString();
+        return false;
+    }
+    return file.write(out) == out.size();
+}
+}
@@ -0,0 +1,72 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include "allocationstats.h"
+#include <QString>
+#include <atomic>
+
+/**
+ * @brief Трассировка времени выполнения в формате Chrome Trace Event.
+ * @details Интервалы записываются в буфер своего потока под его мьютексом,
+ * который кроме владельца захватывает только запись файла, поэтому
+ * блокировка не оспаривается. При выключенной трассировке Span стоит
+ * одну атомарную загрузку.
+ * Результат открывается в chrome://tracing или ui.perfetto.dev.
+ * Трассировка включается переменной окружения DATAANALYS_TRACE=<файл>,
+ * тогда файл записывается при завершении программы.
+ * Интервалы также служат этапами учета памяти AllocationStats.
+ */
+namespace Tracing
+{
+extern std::atomic<bool> enabled;
+
+inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+void setEnabled(bool value);
+
+/**
+ * Включает трассировку, если задана переменная DATAANALYS_TRACE,
+ * и регистрирует запись файла при завершении программы.
+ */
+void enableFromEnvironment();
+
+/// Записывает накопленные интервалы всех потоков в JSON-файл.
+bool writeChromeTrace(const QString &filePath);
+
+/// Интервал от создания до разрушения объекта.
+class Span
+{
+public:
+    /// @param name Строковый литерал, указатель сохраняется без копирования.
+    explicit Span(const char *name) :
+        _name(isEnabled() ? name : nullptr),
+        _start(_name ? now() : 0),
+        _stage(name)
+    {
+    }
+
+    ~Span()
+    {
+        // Запись интервала не относится к этапу учета памяти.
+        _stage.close();
+        if (_name)
+            record(_name, _start, now());
+    }
+
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+private:
+    static qint64 now();
+    static void record(const char *name, qint64 start, qint64 end);
+
+    const char *_name;
+    qint64 _start;
+    AllocationStats::StageScope _stage;
+};
+}
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SPAN(name) Tracing::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#endif // TRACING_H
@@ -1,5 +1,5 @@
 #include "calcunit.h"
-#include "qglobal.h"
+#include "tracing.h"
 #include <algorithm>
 
 calc_unit::calc_unit(double value_a, int lower_value, int top_value) :
@@ -7,9 +7,8 @@ calc_unit::calc_unit(double value_a, int lower_value, int top_value) :
     _lower_value(lower_value),
     _top_value(top_value)
 {
-    calculate_const_value();
-    calculate_expected_value();
-    calculate_dispersion();
+    TRACE_SPAN("calc_unit::calc_unit");
+    calculate_moments();
     calculate_median();
     calculate_mode();
 }
@@ -44,114 +43,75 @@ double calc_unit::standard_deviation() const
     return sqrt(_dispersion);
 }
 
-double calc_unit::probability_density_function(double x) const
+double calc_unit::skewness() const
 {
-    if (x >= _lower_value && x <= _top_value)
-        return x + _value_a;
-    else
-        return 0.0;
+    return _skewness;
 }
 
-double calc_unit::pdf_with_const(double x) const
+double calc_unit::kurtosis() const
 {
-    if (x >= _lower_value && x <= _top_value)
-        return _const_value * (x + _value_a);
-    else
-        return 0.0;
+    return _kurtosis;
 }
 
-double calc_unit::distribution_function(double x) const
+std::vector<double> calc_unit::raw_moments(int order) const
 {
-    auto pdf = [this](double x) { return pdf_with_const(x); };
-
-    if (x < _lower_value)
-    {
-        auto res = integrate(pdf, -std::numeric_limits<double>::infinity(), x, 1000);
-        return std::isnan(res) ? 0 : res;
-    }
-
-    if (x >= _lower_value && x <= _top_value)
-        return  primal_function(x);
-
-    else
-        return integrate(pdf, _lower_value, _top_value, 1000);
+    std::vector<double> result(order + 1);
+    for (int k = 0; k <= order; k++)
+        result[k] = _density.raw_moment(k);
+    return result;
 }
 
-double calc_unit::exp_value_function(double x) const
+double calc_unit::quantile(double probability) const
 {
-    return pdf_with_const(x) * x;
+    return _density.quantile(probability);
 }
 
-double calc_unit::dispersion_function(double x) const
+double calc_unit::pdf_with_const(double x) const
 {
-    return pdf_with_const(x) * pow(x - _expected_value, 2);
+    return _density.pdf(x);
 }
 
-double calc_unit::primal_function(double x) const
+double calc_unit::distribution_function(double x) const
 {
-    if (x >= _lower_value && x <= _top_value)
-        return _const_value * (0.5 * pow(x, 2) + _value_a * x);
-    else
-        return 0.0;
+    return _density.cdf(x);
 }
 
-double calc_unit::integrate(const std::function<double (double)> &func, double a, double b, int n) const
+void calc_unit::calculate_moments()
 {
-    double h = (b - a) / n;
-    double result = func(a) + func(b);
-
-    for (int i = 1; i < n; i += 2)
-        result += 4 * func(a + i * h);
-
-
-    for (int i = 2; i < n - 1; i += 2)
-        result += 2 * func(a + i * h);
+    TRACE_SPAN("calc_unit::calculate_moments");
+    polynomial<1> density(std::array<double, 2>{_value_a, 1.0});
+    _density = piecewise_polynomial<1>({{double(_lower_value), double(_top_value), density}});
+    _const_value = _density.norm();
 
-    auto integral = h / 3 * result;
-    return std::fabs(integral) < std::numeric_limits<double>::epsilon() ? 0.0 : integral;
-}
-
-void calc_unit::calculate_const_value()
-{
-    auto func = [this](double x) { return probability_density_function(x); };
-    _const_value = 1.0 / integrate(func, _lower_value, _top_value, 1000);
-}
+    // Моменты - точные интегралы многочлена плотности, без квадратуры.
+    // Они берутся относительно середины отрезка: так меньше
+    // теряется точность при переходе к центральным моментам.
+    double center = 0.5 * (_lower_value + _top_value);
+    double shift = _density.moment_about(1, center);
+    double m2 = _density.moment_about(2, center);
+    double m3 = _density.moment_about(3, center);
+    double m4 = _density.moment_about(4, center);
 
-void calc_unit::calculate_dispersion()
-{
-    auto func = [this](double x) { return dispersion_function(x); };
-    _dispersion = integrate(func, _lower_value, _top_value, 1000);
-}
+    double shift2 = shift * shift;
+    double central2 = m2 - shift2;
+    double central3 = m3 - 3 * shift * m2 + 2 * shift2 * shift;
+    double central4 = m4 - 4 * shift * m3 + 6 * shift2 * m2 - 3 * shift2 * shift2;
 
-void calc_unit::calculate_expected_value()
-{
-    auto func = [this](double x) { return exp_value_function(x); };
-    _expected_value = integrate(func, _lower_value, _top_value, 1000);
+    _expected_value = center + shift;
+    _dispersion = central2;
+    _skewness = central3 / std::pow(central2, 1.5);
+    _kurtosis = central4 / (central2 * central2) - 3.0;
 }
 
 void calc_unit::calculate_median()
 {
-    double a = 0.5 * _const_value;
-    double b = _const_value * _value_a;
-    double c = -0.5;
-
-    double discriminant = b * b - 4 * a * c;
-
-    if (discriminant >= 0)
-    {
-        double root1 = (-b + std::sqrt(discriminant)) / (2.0 * a);
-        double root2 = (-b - std::sqrt(discriminant)) / (2.0 * a);
-
-        if (root1 >= _lower_value && root1 <= _top_value)
-            _median = root1;
-        else
-            _median = root2;
-    }
-    else Q_ASSERT(true);
+    TRACE_SPAN("calc_unit::calculate_median");
+    _median = _density.quantile(0.5);
 }
 
 void calc_unit::calculate_mode()
 {
+    TRACE_SPAN("calc_unit::calculate_mode");
     double max_density = 0.0;
     _mode_value = _lower_value;
 
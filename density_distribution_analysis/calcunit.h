@@ -1,8 +1,10 @@
 #ifndef CALCUNIT_H
 #define CALCUNIT_H
 
+#include "polynomial.h"
+
 #include <cmath>
-#include <functional>
+#include <vector>
 
 /**
  * @class CalcUnit
@@ -60,72 +62,52 @@ public:
     double standard_deviation() const;
 
     /**
-     * @brief Функция плотности вероятности с константным значением.
-     * @param x Входное значение.
-     * @return Значение функции плотности вероятности с константой.
+     * @brief Получить коэффициент асимметрии распределения.
+     * @return Значение коэффициента асимметрии.
      */
-    double pdf_with_const(double x) const;
+    double skewness() const;
 
     /**
-     * @brief Функция распределения вероятности.
-     * @param x Входное значение.
-     * @return Значение функции распределения вероятности.
+     * @brief Получить эксцесс распределения.
+     * @return Значение эксцесса.
      */
-    double distribution_function(double x) const;
+    double kurtosis() const;
 
-private:
     /**
-     * @brief Функция плотности вероятности для распределения.
-     * @param x Входное значение.
-     * @return Значение функции плотности вероятности.
+     * @brief Начальные моменты распределения до заданного порядка включительно.
+     * @details Моменты считаются точно по первообразной полиномиальной плотности.
+     * @param order Максимальный порядок момента.
+     * @return Вектор моментов E[X^k], k = 0..order.
      */
-    double probability_density_function(double x) const;
+    std::vector<double> raw_moments(int order) const;
 
     /**
-     * @brief Функция для нахождения математического ожидания.
-     * @param x Входное значение.
-     * @return Значение функции для расчета математического ожидания.
+     * @brief Квантиль распределения.
+     * @param probability Уровень квантиля.
+     * @return Значение x, для которого F(x) = probability.
      */
-    double exp_value_function(double x) const;
+    double quantile(double probability) const;
 
     /**
-     * @brief Функция для нахождения дисперсии.
+     * @brief Функция плотности вероятности с константным значением.
      * @param x Входное значение.
-     * @return Значение функции для расчета дисперсии.
+     * @return Значение функции плотности вероятности с константой.
      */
-    double dispersion_function(double x) const;
-
+    double pdf_with_const(double x) const;
 
     /**
-     * @brief Функция первообразной от функции плотности распределения.
+     * @brief Функция распределения вероятности.
      * @param x Входное значение.
-     * @return Значение первообразной функции.
-     */
-    double primal_function(double x) const;
-
-    /**
-     * @brief Функция интеграции с использованием метода Симпсона.
-     * @param func Функция для интегрирования.
-     * @param a Нижняя граница интегрирования.
-     * @param b Верхняя граница интегрирования.
-     * @return Результат интегрирования.
-     */
-    double integrate(const std::function<double(double)> &func, double a, double b, int n) const;
-
-    /**
-     * @brief Вычислить константу C для функции плотности вероятности.
-     */
-    void calculate_const_value();
-
-    /**
-     * @brief Вычислить математическое ожидание.
+     * @return Значение функции распределения вероятности.
      */
-    void calculate_expected_value();
+    double distribution_function(double x) const;
 
+private:
     /**
-     * @brief Вычислить дисперсию.
+     * @brief Вычислить константу C, математическое ожидание, дисперсию,
+     * асимметрию и эксцесс по точным начальным моментам.
      */
-    void calculate_dispersion();
+    void calculate_moments();
 
     /**
      * @brief Вычислить медиану.
@@ -142,9 +124,13 @@ private:
     int _lower_value;
     int _top_value;
 
+    piecewise_polynomial<1> _density;
+
     double _const_value;
     double _expected_value;
     double _dispersion;
+    double _skewness;
+    double _kurtosis;
     double _median;
     double _mode_value;
 };
@@ -1,6 +1,7 @@
 #ifndef CHARTVIEW_H
 #define CHARTVIEW_H
 #include <QChartView>
+#include <QLineSeries>
 
 using namespace QtCharts;
 
@@ -12,16 +13,41 @@ public:
     ChartView(QWidget * parent = nullptr);
     ChartView(QChart * chart, QWidget * parent = nullptr);
 
+    /// Порог числа точек, выше которого серия рисуется через OpenGL.
+    static constexpr int openGLThreshold = 10000;
+    /// Порог числа точек, выше которого анимация графика отключается.
+    static constexpr int animationThreshold = 2000;
+
+    /**
+     * Заменяет точки серии одним вызовом replace() и выбирает режим
+     * отрисовки по их количеству. Для прореженной серии sourceSize - число
+     * точек до прореживания. Серия должна быть уже добавлена на график.
+     */
+    static void setSeriesPoints(QXYSeries *series, const QVector<QPointF> &points, int sourceSize = -1);
+
+    /**
+     * Выводит в series прореженные точки points: на видимый участок оси X
+     * приходится не больше точек, чем пикселей по ширине графика. Прореживание
+     * пересчитывается при масштабировании, прокрутке и изменении размера.
+     */
+    void addDownsampledSeries(QLineSeries *series, const QVector<QPointF> &points);
+
 protected:
     void wheelEvent(QWheelEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void updateDownsampledSeries();
 
 private:
     bool isDragging = false;
     QPoint lastMousePos;
     double currentZoom = 0.5;
+
+    QVector<QPair<QLineSeries *, QVector<QPointF>>> downsampled;
 };
 
 #endif // CHARTVIEW_H
@@ -0,0 +1,73 @@
+#include "downsampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+QVector<QPointF> Downsampler::lttb(const QPointF *points, int size, int threshold)
+{
+    if (threshold >= size || threshold < 3)
+        return QVector<QPointF>(points, points + size);
+
+    QVector<QPointF> result;
+    result.reserve(threshold);
+    result.append(points[0]);
+
+    // Первая и последняя точки сохраняются, остальные делятся на threshold - 2 корзины
+    double bucketSize = static_cast<double>(size - 2) / (threshold - 2);
+    int selected = 0;
+
+    for (int bucket = 0; bucket < threshold - 2; bucket++)
+    {
+        int start = static_cast<int>(std::floor(bucket * bucketSize)) + 1;
+        int end = static_cast<int>(std::floor((bucket + 1) * bucketSize)) + 1;
+
+        int nextStart = end;
+        int nextEnd = std::min(static_cast<int>(std::floor((bucket + 2) * bucketSize)) + 1, size);
+        double averageX = 0.0, averageY = 0.0;
+        for (int i = nextStart; i < nextEnd; i++)
+        {
+            averageX += points[i].x();
+            averageY += points[i].y();
+        }
+        int nextCount = std::max(nextEnd - nextStart, 1);
+        averageX /= nextCount;
+        averageY /= nextCount;
+        if (nextEnd <= nextStart)
+        {
+            averageX = points[size - 1].x();
+            averageY = points[size - 1].y();
+        }
+
+        const QPointF &a = points[selected];
+        double maxArea = -1.0;
+        int chosen = start;
+        for (int i = start; i < end; i++)
+        {
+            double area = std::fabs((a.x() - averageX) * (points[i].y() - a.y()) -
+                                    (a.x() - points[i].x()) * (averageY - a.y()));
+            if (area > maxArea)
+            {
+                maxArea = area;
+                chosen = i;
+            }
+        }
+
+        result.append(points[chosen]);
+        selected = chosen;
+    }
+
+    result.append(points[size - 1]);
+    return result;
+}
+
+std::pair<int, int> Downsampler::visibleRange(const QVector<QPointF> &points, double from, double to)
+{
+    auto byX = [](const QPointF &point, double x) { return point.x() < x; };
+
+    int first = std::lower_bound(points.begin(), points.end(), from, byX) - points.begin();
+    int last = std::lower_bound(points.begin(), points.end(), to, byX) - points.begin();
+
+    first = std::max(first - 1, 0);
+    last = std::min(last + 1, points.size());
+    return {first, last};
+}
@@ -1,5 +1,8 @@
 #include "main_window.h"
 #include "parametersinputdialog.h"
+#include "tracing.h"
+#include "allocationpanel.h"
+#include "perfgate.h"
 #include <QApplication>
 #include <QDebug>
 
@@ -7,9 +10,32 @@
 #include <cmath>
 #include <functional>
 
+namespace
+{
+QVector<PerfGate::Scenario> perfScenarios()
+{
+    return {{"calc_unit", []()
+    {
+        for (int i = 0; i < 1000; i++)
+            calc_unit unit(2.0, 0, 4);
+    }}};
+}
+}
 
 int main(int argc, char *argv[])
 {
+    // DATAANALYS_TRACE=<файл>: запись трассировки в формате Chrome trace при выходе
+    Tracing::enableFromEnvironment();
+    // DATAANALYS_ALLOC_STATS=1: учет памяти по этапам, панель по F12
+    AllocationStats::enableFromEnvironment();
+
+    // --perf-gate <база> / --perf-baseline <база>: проверка производительности без интерфейса
+    if (PerfGate::isRequested(argc, argv))
+    {
+        QCoreApplication app(argc, argv);
+        return PerfGate::run(argc, argv, perfScenarios());
+    }
+
     QApplication app(argc, argv);
 
     int rangeStart, rangeEnd;
@@ -25,6 +51,7 @@ int main(int argc, char *argv[])
         return 0;
 
     MainWindow w(valueA, rangeStart, rangeEnd);
+    AllocationPanel::install(&w);
     w.show();
 
     return app.exec();
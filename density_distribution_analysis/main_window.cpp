@@ -1,4 +1,5 @@
 #include "main_window.h"
+#include "tracing.h"
 
 #include <QChart>
 #include <QPainter>
@@ -19,6 +20,7 @@ MainWindow::MainWindow(double valueA, int startRange, int endRange, QWidget *par
     : QWidget(parent),
     _unit(valueA, startRange, endRange)
 {
+    TRACE_SPAN("MainWindow::MainWindow");
     auto group_graph = new QGroupBox("Графики: ", this);
     auto group_state = new QGroupBox("Характеристики: ", this);
 
@@ -28,6 +30,7 @@ MainWindow::MainWindow(double valueA, int startRange, int endRange, QWidget *par
     auto pdf_series = new QLineSeries(this);
     auto cdf_series = new QLineSeries(this);
 
+    QVector<QPointF> pdf_points, cdf_points;
     double max_cdf_y = 0.0, max_pdf_y = 0.0;
     double min_x = -0.1, max_x = 1.1;
     for (double x = min_x; x <= max_x; x += 0.01)
@@ -35,16 +38,16 @@ MainWindow::MainWindow(double valueA, int startRange, int endRange, QWidget *par
         auto pdf_y = _unit.pdf_with_const(x);
         if (pdf_y > max_pdf_y)
             max_pdf_y = pdf_y;
-        pdf_series->append(x, pdf_y);
+        pdf_points.append(QPointF(x, pdf_y));
 
         auto cdf_y = _unit.distribution_function(x);
         if (cdf_y > max_cdf_y)
             max_cdf_y = cdf_y;
-        cdf_series->append(x, cdf_y);
+        cdf_points.append(QPointF(x, cdf_y));
     }
 
-    graph_layout->addWidget(createWidget(pdf_series, "График плотности распределения", "PDF", min_x, max_x, -0.1, max_pdf_y+0.2, Qt::blue));
-    graph_layout->addWidget(createWidget(cdf_series, "График функции распределения", "CDF",  min_x, max_x, -0.1, max_cdf_y+0.2, Qt::green));
+    graph_layout->addWidget(createWidget(pdf_series, pdf_points, "График плотности распределения", "PDF", min_x, max_x, -0.1, max_pdf_y+0.2, Qt::blue));
+    graph_layout->addWidget(createWidget(cdf_series, cdf_points, "График функции распределения", "CDF",  min_x, max_x, -0.1, max_cdf_y+0.2, Qt::green));
     state_layout->addWidget(createStatWidget());
 
     group_graph->setLayout(graph_layout);
@@ -60,12 +63,13 @@ MainWindow::MainWindow(double valueA, int startRange, int endRange, QWidget *par
     setMinimumHeight(600);
 }
 
-QChartView * MainWindow::createWidget(QLineSeries *series,
+QChartView * MainWindow::createWidget(QLineSeries *series, const QVector<QPointF> &points,
                                        const QString &name, const QString &graph_name,
                                        double min_x, double max_x,
                                        double min_y, double max_y,
                                        Qt::GlobalColor color)
 {
+    TRACE_SPAN("MainWindow::createWidget");
     auto chart = new QChart;
 
     QPen pen(color, 2, Qt::SolidLine);
@@ -98,6 +102,7 @@ QChartView * MainWindow::createWidget(QLineSeries *series,
     chart_view->setRenderHint(QPainter::Antialiasing);
     chart_view->setRubberBand(QChartView::RectangleRubberBand);
     chart_view->setInteractive(true);
+    chart_view->addDownsampledSeries(series, points);
 
     return chart_view;
 }
@@ -113,6 +118,8 @@ QWidget *MainWindow::createStatWidget()
     auto median_label = createCenteredLabel("Медиана: \n", _unit.median(), stat_widget);
     auto mode_label = createCenteredLabel("Мода: \n", _unit.mode_value(), stat_widget);
     auto std_dev_label = createCenteredLabel("Среднее квадратическое  \nотклонение: \n", _unit.standard_deviation(), stat_widget);
+    auto skewness_label = createCenteredLabel("Коэффициент \nасимметрии: \n", _unit.skewness(), stat_widget);
+    auto kurtosis_label = createCenteredLabel("Эксцесс: \n", _unit.kurtosis(), stat_widget);
 
 
     stat_layout->addWidget(const_label);
@@ -121,6 +128,8 @@ QWidget *MainWindow::createStatWidget()
     stat_layout->addWidget(median_label);
     stat_layout->addWidget(mode_label);
     stat_layout->addWidget(std_dev_label);
+    stat_layout->addWidget(skewness_label);
+    stat_layout->addWidget(kurtosis_label);
 
     stat_widget->setLayout(stat_layout);
 
@@ -3,6 +3,8 @@
 
 #include "calcunit.h"
 #include <QWidget>
+#include <QPointF>
+#include <QVector>
 
 namespace QtCharts { class QChartView; class QLineSeries; class QChart; class QValueAxis;}
 class QLabel;
@@ -14,7 +16,7 @@ public:
     explicit MainWindow(double valueA, int startRange, int endRange, QWidget *parent = nullptr);
 
 private:
-    QtCharts::QChartView * createWidget(QtCharts::QLineSeries *series,
+    QtCharts::QChartView * createWidget(QtCharts::QLineSeries *series, const QVector<QPointF> &points,
                                         const QString &name, const QString &graph_name,
                                         double min_x, double max_x,
                                         double min_y, double max_y,
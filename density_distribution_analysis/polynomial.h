@@ -0,0 +1,289 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class polynomial
+ * @brief Многочлен фиксированной степени p(x) = c0 + c1·x + ... + cN·x^N.
+ * @details Все операции над коэффициентами доступны на этапе компиляции,
+ * первообразная и интегралы вычисляются символьно, без квадратуры.
+ */
+template <std::size_t Degree>
+class polynomial
+{
+public:
+    static constexpr std::size_t degree = Degree;
+
+    constexpr polynomial() : _coeffs{} {}
+
+    /**
+     * @brief Конструктор по коэффициентам.
+     * @param coeffs Коэффициенты при степенях x, начиная с нулевой.
+     */
+    constexpr polynomial(const std::array<double, Degree + 1> &coeffs) : _coeffs(coeffs) {}
+
+    /**
+     * @brief Коэффициент при x^k.
+     */
+    constexpr double coefficient(std::size_t k) const
+    {
+        return k <= Degree ? _coeffs[k] : 0.0;
+    }
+
+    /**
+     * @brief Значение многочлена в точке (схема Горнера).
+     */
+    constexpr double operator()(double x) const
+    {
+        double result = 0.0;
+        for (std::size_t k = Degree + 1; k > 0; k--)
+            result = result * x + _coeffs[k - 1];
+        return result;
+    }
+
+    constexpr polynomial operator*(double factor) const
+    {
+        polynomial result;
+        for (std::size_t k = 0; k <= Degree; k++)
+            result._coeffs[k] = _coeffs[k] * factor;
+        return result;
+    }
+
+    constexpr polynomial operator+(const polynomial &other) const
+    {
+        polynomial result;
+        for (std::size_t k = 0; k <= Degree; k++)
+            result._coeffs[k] = _coeffs[k] + other._coeffs[k];
+        return result;
+    }
+
+    /**
+     * @brief Первообразная с нулевой константой интегрирования.
+     */
+    constexpr polynomial<Degree + 1> antiderivative() const
+    {
+        std::array<double, Degree + 2> coeffs{};
+        for (std::size_t k = 0; k <= Degree; k++)
+            coeffs[k + 1] = _coeffs[k] / static_cast<double>(k + 1);
+        return polynomial<Degree + 1>(coeffs);
+    }
+
+    /**
+     * @brief Многочлен, умноженный на x.
+     */
+    constexpr polynomial<Degree + 1> multiply_x() const
+    {
+        std::array<double, Degree + 2> coeffs{};
+        for (std::size_t k = 0; k <= Degree; k++)
+            coeffs[k + 1] = _coeffs[k];
+        return polynomial<Degree + 1>(coeffs);
+    }
+
+    /**
+     * @brief Многочлен q(u) = p(u + shift), коэффициенты по биному Ньютона.
+     */
+    constexpr polynomial shifted(double shift) const
+    {
+        polynomial result;
+        for (std::size_t j = 0; j <= Degree; j++)
+        {
+            // C(j, k) · shift^(j - k) при k = j, j - 1, ..., 0
+            double binomial = 1.0;
+            double power = 1.0;
+            for (std::size_t k = j + 1; k > 0; k--)
+            {
+                result._coeffs[k - 1] += _coeffs[j] * binomial * power;
+                binomial = binomial * static_cast<double>(k - 1) / static_cast<double>(j - k + 2);
+                power *= shift;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Точный интеграл от p(x) на отрезке [a, b].
+     */
+    constexpr double integrate(double a, double b) const
+    {
+        return moment(0, a, b);
+    }
+
+    /**
+     * @brief Точный интеграл от x^k·p(x) на отрезке [a, b].
+     */
+    constexpr double moment(std::size_t k, double a, double b) const
+    {
+        double result = 0.0;
+        for (std::size_t j = 0; j <= Degree; j++)
+        {
+            std::size_t power = j + k + 1;
+            result += _coeffs[j] * (power_of(b, power) - power_of(a, power)) / static_cast<double>(power);
+        }
+        return result;
+    }
+
+private:
+    static constexpr double power_of(double x, std::size_t n)
+    {
+        double result = 1.0;
+        for (std::size_t i = 0; i < n; i++)
+            result *= x;
+        return result;
+    }
+
+private:
+    std::array<double, Degree + 1> _coeffs;
+};
+
+/**
+ * @class piecewise_polynomial
+ * @brief Кусочно-полиномиальная плотность распределения.
+ * @details Плотность нормируется точно, моменты, функция распределения и квантили
+ * считаются по символьным первообразным кусков.
+ */
+template <std::size_t Degree>
+class piecewise_polynomial
+{
+public:
+    struct piece
+    {
+        double left;
+        double right;
+        polynomial<Degree> density;
+    };
+
+    piecewise_polynomial() = default;
+
+    /**
+     * @brief Конструктор по кускам плотности.
+     * @param pieces Куски, упорядоченные по возрастанию и не пересекающиеся.
+     * @details Плотность нормируется так, чтобы интеграл по всем кускам был равен 1.
+     */
+    explicit piecewise_polynomial(const std::vector<piece> &pieces) : _pieces(pieces)
+    {
+        double total = 0.0;
+        for (const auto &p : _pieces)
+            total += p.density.integrate(p.left, p.right);
+
+        _norm = 1.0 / total;
+
+        _cumulative.reserve(_pieces.size() + 1);
+        _cumulative.push_back(0.0);
+        for (auto &p : _pieces)
+        {
+            p.density = p.density * _norm;
+            _cumulative.push_back(_cumulative.back() + p.density.integrate(p.left, p.right));
+        }
+    }
+
+    /**
+     * @brief Нормирующая константа исходной плотности.
+     */
+    double norm() const { return _norm; }
+
+    /**
+     * @brief Значение нормированной плотности в точке.
+     */
+    double pdf(double x) const
+    {
+        for (const auto &p : _pieces)
+            if (x >= p.left && x <= p.right)
+                return p.density(x);
+        return 0.0;
+    }
+
+    /**
+     * @brief Значение функции распределения в точке.
+     */
+    double cdf(double x) const
+    {
+        if (_pieces.empty() || x < _pieces.front().left)
+            return 0.0;
+
+        for (std::size_t i = 0; i < _pieces.size(); i++)
+        {
+            const auto &p = _pieces[i];
+            if (x <= p.right)
+                return _cumulative[i] + (x > p.left ? p.density.integrate(p.left, x) : 0.0);
+        }
+        return 1.0;
+    }
+
+    /**
+     * @brief Начальный момент E[X^k].
+     */
+    double raw_moment(std::size_t k) const
+    {
+        double result = 0.0;
+        for (const auto &p : _pieces)
+            result += p.density.moment(k, p.left, p.right);
+        return result;
+    }
+
+    /**
+     * @brief Момент E[(X - center)^k].
+     * @details Куски сдвигаются к center до интегрирования, поэтому при
+     * отрезке вдали от нуля не теряется точность, как при пересчете
+     * из начальных моментов.
+     */
+    double moment_about(std::size_t k, double center) const
+    {
+        double result = 0.0;
+        for (const auto &p : _pieces)
+            result += p.density.shifted(center).moment(k, p.left - center, p.right - center);
+        return result;
+    }
+
+    /**
+     * @brief Квантиль уровня probability.
+     * @details Нужный кусок находится по накопленным массам, внутри куска
+     * уравнение F(x) = probability решается методом Ньютона с защитой бисекцией.
+     */
+    double quantile(double probability) const
+    {
+        if (_pieces.empty())
+            return 0.0;
+
+        std::size_t i = 0;
+        while (i + 1 < _pieces.size() && _cumulative[i + 1] < probability)
+            i++;
+
+        const auto &p = _pieces[i];
+        double target = probability - _cumulative[i];
+        auto primitive = p.density.antiderivative();
+        double offset = primitive(p.left);
+
+        double lo = p.left;
+        double hi = p.right;
+        double x = 0.5 * (lo + hi);
+        for (int iter = 0; iter < 100; iter++)
+        {
+            double value = primitive(x) - offset - target;
+            if (value > 0)
+                hi = x;
+            else
+                lo = x;
+
+            double slope = p.density(x);
+            double next = slope > 0 ? x - value / slope : 0.5 * (lo + hi);
+            if (next <= lo || next >= hi)
+                next = 0.5 * (lo + hi);
+
+            if (std::fabs(next - x) < 1e-15 * (1.0 + std::fabs(x)))
+                return next;
+            x = next;
+        }
+        return x;
+    }
+
+private:
+    std::vector<piece> _pieces;
+    std::vector<double> _cumulative;
+    double _norm = 1.0;
+};
+
+#endif // POLYNOMIAL_H
@@ -1,9 +1,16 @@
 #include "calcunit.h"
+#include "kerneldensity.h"
+#include "samplefile.h"
+#include "samplekernels.h"
+#include "tracing.h"
 
 #include <cmath>
 #include <random>
 #include <algorithm>
+#include <numeric>
 #include <QHash>
+#include <QThread>
+#include <QtConcurrent>
 #include <QtMath>
 #include <QFile>
 #include <QDataStream>
@@ -18,9 +25,15 @@ double normilize(double value, int decimal)
     return std::round(value * scale) / scale;
 }
 
-CalcUnit::CalcUnit(int variantNumber) :
-    _variantNumber(variantNumber)
+CalcUnit::CalcUnit(int variantNumber, StorageMode storageMode) :
+    _variantNumber(variantNumber),
+    _storageMode(storageMode)
 {
+    TRACE_SPAN("CalcUnit::CalcUnit");
+    // Виртуальные выборки порождаются при каждом запросе, ни файлы, ни память не нужны.
+    if (_storageMode == StorageMode::Virtual)
+        return;
+
     _randomValues.insert({100, false}, {});
     _randomValues.insert({1000, false}, {});
     _randomValues.insert({100, true}, {});
@@ -31,42 +44,48 @@ CalcUnit::CalcUnit(int variantNumber) :
     {
         auto suffix = it.key().second ? "/gauss" : "/uniform";
         auto fileName = dataFilePrefix + suffix + QString::number(it.key().first) + ".txt";
+        auto compactFileName = dataFilePrefix + suffix + QString::number(it.key().first) + ".fp32";
+
+        if (_storageMode == StorageMode::Compact)
+        {
+            auto sample = FixedPointSample::load(compactFileName);
+            if (sample.size() == it.key().first)
+            {
+                _compactValues.insert(it.key(), sample);
+                continue;
+            }
+        }
 
         if (!readDataFromFile(fileName, it.key().second))
         {
             it.key().second ? generateGaussRandomForm(it.key().first) : generateUniformRandomForm(it.key().first);
             writeDataToFile(fileName, it.value());
         }
+
+        if (_storageMode == StorageMode::Compact && FixedPointSample::isRepresentable(it.value()))
+        {
+            FixedPointSample sample(it.value());
+            sample.save(compactFileName);
+            _compactValues.insert(it.key(), sample);
+        }
+
+        if (_storageMode == StorageMode::Float)
+            _floatValues.insert(it.key(), QVector<float>(it.value().cbegin(), it.value().cend()));
     }
+
+    // Переведенные в компактный формат и во float выборки не дублируются в double.
+    for (auto it = _compactValues.cbegin(); it != _compactValues.cend(); it++)
+        _randomValues.remove(it.key());
+    for (auto it = _floatValues.cbegin(); it != _floatValues.cend(); it++)
+        _randomValues.remove(it.key());
 }
 
 bool CalcUnit::readDataFromFile(const QString& filePath, bool isGauss)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        qDebug() << "Failed to open file for reading:" << filePath;
-        return false;
-    }
-
-    QTextStream in(&file);
+    TRACE_SPAN("CalcUnit::readDataFromFile");
     QVector<double> data;
-
-    while (!in.atEnd())
-    {
-        auto line = in.readLine();
-        bool ok;
-        double value = line.toDouble(&ok);
-        if (ok)
-            data.append(value);
-        else
-        {
-            qDebug() << "Failed to convert line to double:" << line;
-            return false;
-        }
-    }
-
-    file.close();
+    if (!SampleFile::read(filePath, data))
+        return false;
 
     _randomValues.insert({data.size(), isGauss}, data);
     return true;
@@ -74,40 +93,13 @@ bool CalcUnit::readDataFromFile(const QString& filePath, bool isGauss)
 
 void CalcUnit::writeDataToFile(const QString& filePath, const QVector<double>& randomData)
 {
+    TRACE_SPAN("CalcUnit::writeDataToFile");
     QDir().mkpath(QFileInfo(filePath).absolutePath());
-
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        qDebug() << "Failed to open file for writing:" << filePath << file.errorString();
-        return;
-    }
-
-    QTextStream out(&file);
-    for (const auto& value : qAsConst(randomData))
-        out << QString::number(value) << "\n";
-
-    file.close();
+    SampleFile::write(filePath, randomData);
 }
 
-std::pair<double, double> min_max_element(const QVector<double>& data)
-{
-    if (data.empty())
-        return {0, 0};
-
-    double min = data[0];
-    double max = data[0];
-    for (const auto& value : data)
-    {
-        if (value < min)
-            min = value;
-        if (value > max)
-            max = value;
-    }
-    return {min, max};
-}
-
-double CalcUnit::calculateMode(const QVector<double> &data, int size)
+template<typename T>
+double CalcUnit::calculateMode(const QVector<T> &data, int size) const
 {
     auto hist = createHistogramSet(data, size);
     int maxIndex = 0;
@@ -117,68 +109,350 @@ double CalcUnit::calculateMode(const QVector<double> &data, int size)
             maxIndex = i;
     }
 
-    auto min_max = min_max_element(data);
-    double range = min_max.second - min_max.first;
+    auto min_max = std::minmax_element(data.begin(), data.end());
+    double range = *min_max.second - *min_max.first;
     double delta = range / size;
-    double start_x = min_max.first + maxIndex * delta;
-    double end_x = min_max.first + (maxIndex + 1) * delta;
+    double start_x = *min_max.first + maxIndex * delta;
+    double end_x = *min_max.first + (maxIndex + 1) * delta;
 
     return (start_x + end_x) / 2;
 }
 
-Statistics CalcUnit::calculateStatistics(const QVector<double> &data, int size)
+template<typename T>
+Statistics CalcUnit::sampleStatistics(const QVector<T> &data, int size, double densityMode) const
 {
-    QVector<double> sortedData = data;
+    QVector<T> sortedData = data;
     std::sort(sortedData.begin(), sortedData.end());
 
-    double expectedValue = std::accumulate(data.begin(), data.end(), 0.0) / data.size();
+    auto moments = SampleKernels::moments<2>(data.constData(), data.size());
+    double expectedValue = moments.mean;
     double mode = calculateMode(data, size);
 
-    double median = (sortedData[sortedData.size() / 2 - 1] + sortedData[sortedData.size() / 2]) / 2.0;
+    double median = (static_cast<double>(sortedData[sortedData.size() / 2 - 1]) + sortedData[sortedData.size() / 2]) / 2.0;
+
+    double dispersion = moments.m2 * (1.0 / (data.size() - 1.0));
+    double std_dev = std::sqrt(dispersion);
+
+    return {expectedValue, dispersion, median, mode, std_dev, densityMode};
+}
+
+Statistics CalcUnit::calculateStatistics(const QVector<double> &data, int size) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return sampleStatistics(data, size, KernelDensity(data).mode());
+}
+
+Statistics CalcUnit::calculateStatistics(const QVector<double> &data, int size, const KernelDensity &density) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return sampleStatistics(data, size, density.mode());
+}
+
+Statistics CalcUnit::calculateStatistics(const QVector<float> &data, int size) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return sampleStatistics(data, size, KernelDensity(data).mode());
+}
+
+Statistics CalcUnit::calculateStatistics(const QVector<float> &data, int size, const KernelDensity &density) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return sampleStatistics(data, size, density.mode());
+}
+
+QVector<int> CalcUnit::createHistogramSet(const QVector<double>& data, int size) const
+{
+    TRACE_SPAN("CalcUnit::createHistogramSet");
+    return SampleKernels::histogram(data.constData(), data.size(), size);
+}
+
+QVector<int> CalcUnit::createHistogramSet(const QVector<float>& data, int size) const
+{
+    TRACE_SPAN("CalcUnit::createHistogramSet");
+    return SampleKernels::histogram(data.constData(), data.size(), size);
+}
 
+Statistics CalcUnit::calculateStatistics(const FixedPointSample &data, int size) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    // Значения раскодируются блоками, чтобы не держать копию выборки в double.
+    KernelDensity density([&data](const std::function<void(const double *, int)> &visitor)
+    {
+        data.forEachBlock(visitor);
+    }, FixedPointSample::decode(data.minimum()), FixedPointSample::decode(data.maximum()));
+    return calculateStatistics(data, size, density);
+}
+
+Statistics CalcUnit::calculateStatistics(const FixedPointSample &data, int size, const KernelDensity &density) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    const auto sortedData = data.sorted();
+    const int count = data.size();
+
+    double expectedValue = data.sum() / static_cast<double>(count) / FixedPointSample::scale;
+    double median = (FixedPointSample::decode(sortedData[count / 2 - 1]) + FixedPointSample::decode(sortedData[count / 2])) / 2.0;
+
+    auto hist = createHistogramSet(data, size);
+    int maxIndex = std::max_element(hist.begin(), hist.end()) - hist.begin();
+    double min = FixedPointSample::decode(data.minimum());
+    double delta = (FixedPointSample::decode(data.maximum()) - min) / size;
+    double start_x = min + maxIndex * delta;
+    double end_x = min + (maxIndex + 1) * delta;
+    double mode = (start_x + end_x) / 2;
+
+    // Отклонения считаются в целых единицах, масштаб учитывается один раз.
+    double meanRaw = data.sum() / static_cast<double>(count);
     double dispersion = 0.0;
-    for (const auto & value : qAsConst(data))
-        dispersion += std::pow(value - expectedValue, 2);
+    for (const auto &value : data.values())
+        dispersion += std::pow(value - meanRaw, 2);
 
-    dispersion = dispersion * (1.0 / (data.size() - 1.0));
+    dispersion = dispersion / (static_cast<double>(FixedPointSample::scale) * FixedPointSample::scale) * (1.0 / (count - 1.0));
     double std_dev = std::sqrt(dispersion);
 
-    return {expectedValue, dispersion, median, mode, std_dev};
+    return {expectedValue, dispersion, median, mode, std_dev, density.mode()};
 }
 
-QVector<int> CalcUnit::createHistogramSet(const QVector<double>& data, int size)
+QVector<int> CalcUnit::createHistogramSet(const FixedPointSample &data, int size) const
 {
-    auto min_max = min_max_element(data);
+    TRACE_SPAN("CalcUnit::createHistogramSet");
+    return data.histogram(size);
+}
 
-    double range = min_max.second - min_max.first;
-    double delta = range / size;
+QVector<double> CalcUnit::uniformElements(int size) const
+{
+    auto compact = _compactValues.constFind({size, false});
+    if (compact != _compactValues.cend())
+        return compact.value().toDoubles();
+    auto floats = _floatValues.constFind({size, false});
+    if (floats != _floatValues.cend())
+        return QVector<double>(floats.value().cbegin(), floats.value().cend());
+    return _randomValues.value({size, false});
+}
 
-    QVector<int> hist(size, 0);
-    for (const auto &value : data)
+QVector<double> CalcUnit::gaussElements(int size) const
+{
+    auto compact = _compactValues.constFind({size, true});
+    if (compact != _compactValues.cend())
+        return compact.value().toDoubles();
+    auto floats = _floatValues.constFind({size, true});
+    if (floats != _floatValues.cend())
+        return QVector<double>(floats.value().cbegin(), floats.value().cend());
+    return _randomValues.value({size, true});
+}
+
+FixedPointSample CalcUnit::compactElements(int size, bool gauss) const
+{
+    return _compactValues.value({size, gauss});
+}
+
+QVector<float> CalcUnit::floatElements(int size, bool gauss) const
+{
+    return _floatValues.value({size, gauss});
+}
+
+VirtualDataset CalcUnit::virtualElements(qint64 size, bool gauss) const
+{
+    quint64 seed = static_cast<quint64>(_variantNumber) << 48 ^ static_cast<quint64>(size) << 1 ^ (gauss ? 1u : 0u);
+
+    if (gauss)
+        return VirtualDataset(VirtualDataset::Gauss, _variantNumber, _variantNumber / 3.0, seed, size);
+
+    const double variableA = -_variantNumber / 10.0;
+    const double variableB = _variantNumber / 2.0;
+    return VirtualDataset(VirtualDataset::Uniform, variableA, variableB, seed, size);
+}
+
+QVector<int> CalcUnit::createHistogramSet(const VirtualDataset &data, int size) const
+{
+    TRACE_SPAN("CalcUnit::createHistogramSet");
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    data.forEachBlock([&min, &max](const double *values, int count)
     {
-        for (int i = 0; i < size; ++i)
+        for (int i = 0; i < count; i++)
         {
-            double start_x = min_max.first + i * delta;
-            double end_x = min_max.first + (i + 1) * delta;
+            min = std::min(min, values[i]);
+            max = std::max(max, values[i]);
+        }
+    });
 
-            if (value >= start_x && value <= end_x)
-            {
-                hist[i]++;
-                break;
-            }
+    QVector<int> hist(size, 0);
+    if (data.isEmpty())
+        return hist;
+
+    // Правило то же, что у createHistogramSet для выборки в памяти, блоки добавляются к hist.
+    data.forEachBlock([&](const double *values, int count)
+    {
+        SampleKernels::histogram(values, count, min, max, size, hist.data());
+    });
+    return hist;
+}
+
+Statistics CalcUnit::calculateStatistics(const VirtualDataset &data, int size) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return calculateStatistics(virtualShards(data, QThread::idealThreadCount()), size);
+}
+
+namespace
+{
+/// Предел значений окна медианы, передаваемых из одного прохода
+constexpr qint64 maxWindow = 1 << 20;
+
+/// Интервал эскиза, содержащий значение заданного ранга
+struct RankBin
+{
+    AccumulatorLayout layout;   ///< Разметка с окном из этого интервала
+    qint64 below = 0;           ///< Число значений в предыдущих интервалах
+    bool tied = false;          ///< Переполнен и не разбивается: значения совпадают до шага double
+};
+
+/// Поиск интервала эскиза с рангом rank. Переполненный интервал вместе с соседними
+/// разбивается новым эскизом, чтобы совпадающие значения или далекие выбросы
+/// не превращали окно в большую часть выборки.
+RankBin locateRank(const CalcUnit::AccumulatorPass &pass, AccumulatorLayout layout,
+                   QVector<qint64> sketch, qint64 rank)
+{
+    // Разбиение сужает диапазон в sketchBins / 3 раз, восьми хватает до шага double.
+    constexpr int maxRefinements = 8;
+    layout.bins = 0;
+    for (int refinement = 0; ; refinement++)
+    {
+        int bin = 0;
+        qint64 below = 0;
+        while (bin < sketch.size() - 1 && below + sketch[bin] <= rank)
+            below += sketch[bin++];
+
+        const double step = (layout.upper - layout.lower) / layout.sketchBins;
+        const double lower = layout.lower + std::max(bin - 1, 0) * step;
+        const double upper = layout.lower + std::min(bin + 2, layout.sketchBins) * step;
+        if (sketch[bin] <= maxWindow || refinement == maxRefinements || !(lower < upper))
+        {
+            layout.windowFirst = bin;
+            layout.windowLast = bin;
+            return {layout, below, sketch[bin] > maxWindow};
         }
+
+        // Значения за краями нового диапазона попадают в крайние интервалы,
+        // поэтому накопленные частоты остаются рангами всей выборки.
+        layout.lower = lower;
+        layout.upper = upper;
+        sketch = pass(layout).sketch();
     }
-    return hist;
 }
 
-QVector<double> CalcUnit::uniformElements(int size)
+/// Значение ранга rank из окна интервала, NaN при неполном окне
+double rankValue(const CalcUnit::AccumulatorPass &pass, const RankBin &bin, qint64 rank)
 {
-    return _randomValues.value({size, false});
+    if (bin.tied)
+    {
+        const double step = (bin.layout.upper - bin.layout.lower) / bin.layout.sketchBins;
+        return bin.layout.lower + (bin.layout.windowFirst + 0.5) * step;
+    }
+    auto window = pass(bin.layout).window();
+    const qint64 index = rank - bin.below;
+    if (window.size() <= index)
+        return std::numeric_limits<double>::quiet_NaN();
+    std::nth_element(window.begin(), window.begin() + index, window.end());
+    return window[index];
+}
 }
 
-QVector<double> CalcUnit::gaussElements(int size)
+Statistics CalcUnit::calculateStatistics(const AccumulatorPass &pass, int size) const
 {
-    return _randomValues.value({size, true});
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    // Эскиза из 2^14 интервалов хватает, чтобы окно медианы было малой долей выборки,
+    // и он остается небольшим при передаче между процессами.
+    constexpr int sketchBins = 1 << 14;
+
+    // Первый проход: моменты и крайние значения.
+    const auto moments = pass(AccumulatorLayout());
+    const qint64 count = moments.count();
+    const double min = moments.minimum();
+    const double max = moments.maximum();
+    if (count < 2)
+        return {moments.mean(), 0.0, moments.mean(), moments.mean(), 0.0, moments.mean()};
+
+    // Второй проход: гистограмма для моды и эскиз рангов для медианы.
+    AccumulatorLayout layout;
+    layout.lower = min;
+    layout.upper = max;
+    layout.bins = size;
+    layout.sketchBins = sketchBins;
+    const auto distribution = pass(layout);
+
+    const auto &hist = distribution.histogram();
+    int maxIndex = std::max_element(hist.begin(), hist.end()) - hist.begin();
+    double delta = (max - min) / size;
+    double start_x = min + maxIndex * delta;
+    double end_x = min + (maxIndex + 1) * delta;
+    double mode = (start_x + end_x) / 2;
+
+    // Третий проход: значения из интервалов эскиза, содержащих средние ранги.
+    const auto &sketch = distribution.sketch();
+    const qint64 lowRank = count / 2 - 1;
+    const qint64 highRank = count / 2;
+    const auto low = locateRank(pass, layout, sketch, lowRank);
+    const auto high = locateRank(pass, layout, sketch, highRank);
+
+    double median;
+    if (!low.tied && !high.tied && low.layout.lower == high.layout.lower
+        && low.layout.upper == high.layout.upper)
+    {
+        auto window = low.layout;
+        window.windowLast = high.layout.windowLast;
+        auto middle = pass(window).window();
+        std::sort(middle.begin(), middle.end());
+
+        // Окно неполно, только если участки изменились между проходами.
+        median = middle.size() > highRank - low.below
+                 ? (middle[lowRank - low.below] + middle[highRank - low.below]) / 2.0
+                 : std::numeric_limits<double>::quiet_NaN();
+    }
+    else
+        median = (rankValue(pass, low, lowRank) + rankValue(pass, high, highRank)) / 2.0;
+
+    // Оценка плотности строится по эскизу второго прохода без отдельного прохода.
+    KernelDensity density(sketch, min, max);
+
+    return {moments.mean(), moments.dispersion(), median, mode, std::sqrt(moments.dispersion()),
+            density.mode()};
+}
+
+Statistics CalcUnit::calculateStatistics(const QVector<SampleShard> &shards, int size) const
+{
+    return calculateStatistics([&shards](const AccumulatorLayout &layout)
+    {
+        // Число одновременно обрабатываемых участков ограничено пулом потоков Qt.
+        std::vector<StatisticsAccumulator> results(shards.size());
+        QVector<int> indices(shards.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        QtConcurrent::blockingMap(indices, [&shards, &results, &layout](int index)
+        {
+            results[index] = accumulateShard(shards[index], layout);
+        });
+
+        // Участки объединяются по порядку, чтобы результат не зависел от потоков.
+        StatisticsAccumulator total(layout);
+        for (const auto &result : results)
+            total.merge(result);
+        return total;
+    }, size);
+}
+
+QVector<SampleShard> CalcUnit::virtualShards(const VirtualDataset &data, int count)
+{
+    QVector<SampleShard> shards;
+    for (int i = 0; i < count; i++)
+    {
+        const qint64 from = data.size() * i / count;
+        const qint64 to = data.size() * (i + 1) / count;
+        shards.append([data, from, to](const std::function<void(const double *, int)> &visitor)
+        {
+            data.forEachBlock(from, to, visitor);
+        });
+    }
+    return shards;
 }
 
 void CalcUnit::generateUniformRandom(int size)
@@ -212,6 +486,7 @@ void CalcUnit::generateGaussRandom(int size)
 
 void CalcUnit::generateUniformRandomForm(int size)
 {
+    TRACE_SPAN("CalcUnit::generateUniformRandomForm");
     const double variableA = -_variantNumber / 10.0;
     const double variableB = _variantNumber / 2.0;
 
@@ -231,6 +506,7 @@ void CalcUnit::generateUniformRandomForm(int size)
 
 void CalcUnit::generateGaussRandomForm(int size)
 {
+    TRACE_SPAN("CalcUnit::generateGaussRandomForm");
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_real_distribution<double> dis(0.0, 1.0);
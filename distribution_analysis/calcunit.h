@@ -3,6 +3,12 @@
 
 #include <QVector>
 #include <QHash>
+#include "fixedpointsample.h"
+#include "virtualdataset.h"
+#include "statisticsaccumulator.h"
+
+class KernelDensity;
+
 struct Statistics
 {
     double expectedValue;       ///< Математическое ожидание
@@ -10,18 +16,86 @@ struct Statistics
     double median;              ///< Медиана
     double modeValue;           ///< Мода
     double standardDeviation;   ///< Среднеквадратичное отклонение
+    double densityMode;         ///< Мода по ядерной оценке плотности
+};
+
+enum class StorageMode
+{
+    Text,       ///< Выборки в double, кэш в текстовых файлах
+    Compact,    ///< Выборки и кэш в формате с фиксированной точкой (FixedPointSample)
+    Float,      ///< Выборки во float, кэш в текстовых файлах
+    Virtual     ///< Выборки не хранятся, а порождаются по запросу (VirtualDataset)
 };
 
 class CalcUnit
 {
 public:
-    CalcUnit(int variantNumber = 15);
+    CalcUnit(int variantNumber = 15, StorageMode storageMode = StorageMode::Text);
+
+    Statistics calculateStatistics(const QVector<double>& data, int size) const;
+    QVector<int> createHistogramSet(const QVector<double>& data, int size) const;
+
+    /// Мода плотности берется из уже построенной по data оценки.
+    Statistics calculateStatistics(const QVector<double>& data, int size, const KernelDensity &density) const;
+
+    /// Выборка во float вдвое меньше в памяти, расчет тот же, накопление в double.
+    Statistics calculateStatistics(const QVector<float>& data, int size) const;
+    Statistics calculateStatistics(const QVector<float>& data, int size, const KernelDensity &density) const;
+    QVector<int> createHistogramSet(const QVector<float>& data, int size) const;
+
+    Statistics calculateStatistics(const FixedPointSample& data, int size) const;
+    Statistics calculateStatistics(const FixedPointSample& data, int size, const KernelDensity &density) const;
+    QVector<int> createHistogramSet(const FixedPointSample& data, int size) const;
+
+    /**
+     * Потоковые варианты для выборок, не помещающихся в память: данные
+     * порождаются блоками за несколько проходов. Характеристики считаются
+     * по участкам virtualShards параллельно, как для AccumulatorPass.
+     */
+    Statistics calculateStatistics(const VirtualDataset& data, int size) const;
+    QVector<int> createHistogramSet(const VirtualDataset& data, int size) const;
+
+    /// Проход по всем участкам выборки с объединением их накопителей.
+    using AccumulatorPass = std::function<StatisticsAccumulator(const AccumulatorLayout &)>;
+
+    /**
+     * Расчет по участкам выборки за три прохода: моменты и крайние значения,
+     * гистограмма с квантильным эскизом, окно значений для точной медианы.
+     * Переполненные интервалы эскиза у медианы (совпадающие значения, выбросы)
+     * разбиваются дополнительными проходами, в интервале окна не больше 2^20 значений.
+     * Медиана и мода совпадают с расчетом по всей выборке, математическое
+     * ожидание и дисперсия - с точностью до округления. Оценка плотности
+     * строится по эскизу, ее мода отличается от расчета в памяти в пределах шага эскиза.
+     */
+    Statistics calculateStatistics(const AccumulatorPass &pass, int size) const;
+
+    /// Участки обрабатываются параллельно в глобальном пуле потоков Qt.
+    Statistics calculateStatistics(const QVector<SampleShard> &shards, int size) const;
+
+    /// Равные участки виртуальной выборки.
+    static QVector<SampleShard> virtualShards(const VirtualDataset &data, int count);
+
+    StorageMode storageMode() const { return _storageMode; }
+
+    /// Выборка в double. Пуста в режиме Virtual: выборка не хранится, см. virtualElements.
+    QVector<double> uniformElements(int size) const;
+    QVector<double> gaussElements(int size) const;
+
+    /**
+     * Выборка в формате с фиксированной точкой. Пуста, если компактное
+     * хранение выключено или значения не представимы в int32.
+     */
+    FixedPointSample compactElements(int size, bool gauss) const;
 
-    Statistics calculateStatistics(const QVector<double>& data, int size);
-    QVector<int> createHistogramSet(const QVector<double>& data, int size);
+    /// Выборка во float. Пуста, если хранение во float выключено.
+    QVector<float> floatElements(int size, bool gauss) const;
 
-    QVector<double> uniformElements(int size);
-    QVector<double> gaussElements(int size);
+    /**
+     * Виртуальная выборка произвольного размера с теми же параметрами
+     * распределения, что у сохраняемых. Начальное значение определяется
+     * вариантом, законом и размером.
+     */
+    VirtualDataset virtualElements(qint64 size, bool gauss) const;
 
 private:
     void generateUniformRandom(int size);
@@ -30,14 +104,20 @@ private:
     void generateUniformRandomForm(int size);
     void generateGaussRandomForm(int size);
 
-    double calculateMode(const QVector<double>& data, int size);
+    template<typename T>
+    double calculateMode(const QVector<T>& data, int size) const;
+    template<typename T>
+    Statistics sampleStatistics(const QVector<T>& data, int size, double densityMode) const;
     bool readDataFromFile(const QString &fileName, bool isGauss);
     void writeDataToFile(const QString &fileName, const QVector<double> &randomData);
 
 private:
     QHash<std::pair<int /*size*/, bool /*gauss*/>, QVector<double> /*data*/> _randomValues;
+    QHash<std::pair<int /*size*/, bool /*gauss*/>, FixedPointSample /*data*/> _compactValues;
+    QHash<std::pair<int /*size*/, bool /*gauss*/>, QVector<float> /*data*/> _floatValues;
 
     int _variantNumber;
+    StorageMode _storageMode;
 };
 
 #endif // CALCUNIT_H
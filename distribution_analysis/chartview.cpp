@@ -1,7 +1,70 @@
 #include "chartview.h"
+#include "histogrampyramid.h"
+#include "kerneldensity.h"
+
+#include <QBarSet>
+#include <QBarCategoryAxis>
+#include <QValueAxis>
+#include <QLineSeries>
+#include <QXYSeries>
 
 using namespace QtCharts;
 
+namespace
+{
+const int pixelsPerBar = 20;
+const int minVisibleBins = 4;
+const int curveSamples = 256;
+const int minPixelsPerTick = 50;
+
+/**
+ * Число делений оси значений, совпадающих с границами столбцов: шаг делений -
+ * наименьший делитель числа столбцов, при котором подписи не теснее minPixelsPerTick.
+ */
+int alignedTickCount(int bins, double plotWidth)
+{
+    if (bins <= 0)
+        return 2;
+
+    int maxIntervals = plotWidth > 0 ? qMax(1, static_cast<int>(plotWidth) / minPixelsPerTick) : bins;
+    for (int step = 1; step < bins; step++)
+    {
+        if (bins % step == 0 && bins / step <= maxIntervals)
+            return bins / step + 1;
+    }
+    return 2;
+}
+
+/// Число точек серии до прореживания, по нему выбирается режим анимации.
+const char *const sourcePointsProperty = "sourcePointCount";
+/// Настройки анимации графика, действовавшие до ее отключения.
+const char *const savedAnimationProperty = "savedAnimationOptions";
+
+/**
+ * Анимация выключена, пока хотя бы у одной серии графика больше
+ * ChartView::animationThreshold точек, после этого прежние настройки возвращаются.
+ */
+void updateAnimation(QChart *chart)
+{
+    bool large = false;
+    const auto seriesList = chart->series();
+    for (auto item : seriesList)
+        large = large || item->property(sourcePointsProperty).toInt() > ChartView::animationThreshold;
+
+    QVariant saved = chart->property(savedAnimationProperty);
+    if (large && !saved.isValid())
+    {
+        chart->setProperty(savedAnimationProperty, static_cast<int>(chart->animationOptions()));
+        chart->setAnimationOptions(QChart::NoAnimation);
+    }
+    else if (!large && saved.isValid())
+    {
+        chart->setAnimationOptions(QChart::AnimationOptions(saved.toInt()));
+        chart->setProperty(savedAnimationProperty, QVariant());
+    }
+}
+}
+
 ChartView::ChartView(QWidget *parent) : QChartView(parent)
 {
 
@@ -11,24 +74,93 @@ ChartView::ChartView(QChart *chart, QWidget *parent) : QChartView(chart, parent)
 {
 }
 
+void ChartView::setHistogram(QSharedPointer<HistogramPyramid> pyramid,
+                             QBarSet *set,
+                             QBarCategoryAxis *categoryAxis,
+                             QValueAxis *dataAxis,
+                             QLineSeries *curve,
+                             QSharedPointer<KernelDensity> density)
+{
+    this->pyramid = pyramid;
+    this->barSet = set;
+    this->categoryAxis = categoryAxis;
+    this->dataAxis = dataAxis;
+    this->curve = curve;
+    this->density = density;
+
+    baseValues.clear();
+    for (int i = 0; i < set->count(); i++)
+        baseValues << set->at(i);
+    baseLabels = categoryAxis->categories();
+
+    visibleFrom = pyramid->minimum();
+    visibleTo = pyramid->maximum();
+    showHistogram(baseValues, baseLabels, visibleFrom, visibleTo);
+}
+
+void ChartView::setBaseHistogram(const QVector<int> &counts)
+{
+    baseValues.clear();
+    baseLabels.clear();
+    for (int i = 0; i < counts.size(); i++)
+    {
+        baseValues << counts[i];
+        baseLabels << QString::number(i + 1);
+    }
+
+    visibleFrom = pyramid->minimum();
+    visibleTo = pyramid->maximum();
+    showHistogram(baseValues, baseLabels, visibleFrom, visibleTo);
+}
+
+void ChartView::setSeriesPoints(QXYSeries *series, const QVector<QPointF> &points, int sourceSize)
+{
+    series->setUseOpenGL(points.size() > openGLThreshold);
+    series->replace(points);
+
+    series->setProperty(sourcePointsProperty, sourceSize < 0 ? points.size() : sourceSize);
+    if (series->chart())
+        updateAnimation(series->chart());
+}
+
 void ChartView::wheelEvent(QWheelEvent *event)
 {
-    if (event->angleDelta().y() != 0)
+    if (event->angleDelta().y() == 0)
+        return;
+
+    if (pyramid)
     {
-        if (event->angleDelta().y() > 0 && currentZoom < 1.0)
-        {
-            currentZoom += 0.1;
-            chart()->zoomIn();
-        }
+        double fullRange = pyramid->maximum() - pyramid->minimum();
+        double width = visibleTo - visibleFrom;
+        double minWidth = fullRange / HistogramPyramid::finestBins * minVisibleBins;
 
-        else if (event->angleDelta().y() < 0 && currentZoom > 0.1)
-        {
-            currentZoom -= 0.1;
-            chart()->zoomOut();
-        }
+        QRectF plot = chart()->plotArea();
+        double fraction = plot.width() > 0 ? (event->position().x() - plot.left()) / plot.width() : 0.5;
+        fraction = qBound(0.0, fraction, 1.0);
+
+        double newWidth = event->angleDelta().y() > 0 ? width / 2 : width * 2;
+        newWidth = qBound(minWidth, newWidth, fullRange);
+
+        double anchor = visibleFrom + fraction * width;
+        setVisibleRange(anchor - fraction * newWidth, anchor + (1 - fraction) * newWidth);
 
         event->accept();
+        return;
     }
+
+    if (event->angleDelta().y() > 0 && currentZoom < 1.0)
+    {
+        currentZoom += 0.1;
+        chart()->zoomIn();
+    }
+
+    else if (event->angleDelta().y() < 0 && currentZoom > 0.1)
+    {
+        currentZoom -= 0.1;
+        chart()->zoomOut();
+    }
+
+    event->accept();
 }
 
 void ChartView::mousePressEvent(QMouseEvent *event)
@@ -45,8 +177,18 @@ void ChartView::mouseMoveEvent(QMouseEvent *event)
     if (isDragging)
     {
         QPoint delta = event->pos() - lastMousePos;
-        chart()->scroll(-delta.x(), delta.y());
         lastMousePos = event->pos();
+
+        if (pyramid)
+        {
+            double width = visibleTo - visibleFrom;
+            double plotWidth = chart()->plotArea().width();
+            double shift = plotWidth > 0 ? -delta.x() / plotWidth * width : 0.0;
+            setVisibleRange(visibleFrom + shift, visibleTo + shift);
+            return;
+        }
+
+        chart()->scroll(-delta.x(), delta.y());
     }
 }
 
@@ -57,3 +199,99 @@ void ChartView::mouseReleaseEvent(QMouseEvent *event)
         isDragging = false;
     }
 }
+
+void ChartView::setVisibleRange(double from, double to)
+{
+    double width = to - from;
+    if (from < pyramid->minimum())
+    {
+        from = pyramid->minimum();
+        to = from + width;
+    }
+    if (to > pyramid->maximum())
+    {
+        to = pyramid->maximum();
+        from = qMax(pyramid->minimum(), to - width);
+    }
+
+    if (from == visibleFrom && to == visibleTo)
+        return;
+
+    visibleFrom = from;
+    visibleTo = to;
+    renderHistogram();
+}
+
+void ChartView::renderHistogram()
+{
+    if (visibleFrom <= pyramid->minimum() && visibleTo >= pyramid->maximum())
+    {
+        showHistogram(baseValues, baseLabels, pyramid->minimum(), pyramid->maximum());
+        return;
+    }
+
+    int maxBins = qMax(minVisibleBins, static_cast<int>(chart()->plotArea().width()) / pixelsPerBar);
+    auto slice = pyramid->slice(visibleFrom, visibleTo, maxBins);
+
+    QList<qreal> values;
+    QStringList labels;
+    for (int i = 0; i < slice.counts.size(); i++)
+    {
+        values << slice.counts[i];
+        labels << QString::number(slice.start + (i + 0.5) * slice.binWidth, 'g', 4);
+    }
+
+    showHistogram(values, labels, slice.start, slice.start + slice.counts.size() * slice.binWidth);
+}
+
+void ChartView::showHistogram(const QList<qreal> &values, const QStringList &labels, double from, double to)
+{
+    barSet->remove(0, barSet->count());
+    barSet->append(values);
+
+    categoryAxis->clear();
+    categoryAxis->append(labels);
+
+    dataAxis->setRange(from, to);
+    dataAxis->setTickCount(alignedTickCount(values.size(), chart()->plotArea().width()));
+
+    qreal maxValue = 0;
+    for (const auto value : values)
+        maxValue = qMax(maxValue, value);
+
+    if (curve)
+    {
+        auto points = curvePoints(values, from, to);
+        for (const auto &point : qAsConst(points))
+            maxValue = qMax(maxValue, point.y());
+        setSeriesPoints(curve, points);
+    }
+
+    const auto verticalAxes = chart()->axes(Qt::Vertical);
+    for (auto axis : verticalAxes)
+        axis->setRange(0, maxValue * 1.1);
+}
+
+QVector<QPointF> ChartView::curvePoints(const QList<qreal> &values, double from, double to) const
+{
+    QVector<QPointF> points;
+    if (!density || density->isEmpty() || values.isEmpty() || to <= from)
+    {
+        points.reserve(values.size());
+        for (int i = 0; i < values.size(); i++)
+            points << QPointF(i, values[i]);
+        return points;
+    }
+
+    // Плотность переводится в ожидаемое число значений на интервал столбца,
+    // абсцисса - в координаты оси категорий, где столбец i занимает [i - 0.5, i + 0.5].
+    const double binWidth = (to - from) / values.size();
+    const double scale = density->count() * binWidth;
+    points.reserve(curveSamples);
+    for (int i = 0; i < curveSamples; i++)
+    {
+        double x = from + (to - from) * i / (curveSamples - 1);
+        points << QPointF((x - from) / binWidth - 0.5, density->valueAt(x) * scale);
+    }
+    return points;
+}
@@ -0,0 +1,201 @@
+#include "fixedpointsample.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+const quint32 fileSignature = 0x50465044; // "DFPF"
+
+struct FileHeader
+{
+    quint32 signature;
+    quint32 decimals;
+    quint64 count;
+};
+
+qint32 encode(double value)
+{
+    return static_cast<qint32>(std::llround(value * FixedPointSample::scale));
+}
+
+/**
+ * Наибольшее целое, декодированное значение которого не превышает bound.
+ */
+qint64 upperThreshold(double bound)
+{
+    qint64 raw = static_cast<qint64>(std::floor(bound * FixedPointSample::scale));
+    while (FixedPointSample::decode(raw + 1) <= bound)
+        raw++;
+    while (FixedPointSample::decode(raw) > bound)
+        raw--;
+    return raw;
+}
+}
+
+FixedPointSample::FixedPointSample(const QVector<double> &data)
+{
+    _values.resize(data.size());
+    for (int i = 0; i < data.size(); i++)
+        _values[i] = encode(data[i]);
+
+    if (!_values.isEmpty())
+    {
+        auto min_max = std::minmax_element(_values.begin(), _values.end());
+        _min = *min_max.first;
+        _max = *min_max.second;
+    }
+}
+
+bool FixedPointSample::isRepresentable(const QVector<double> &data)
+{
+    const double limit = static_cast<double>(std::numeric_limits<qint32>::max()) / scale;
+    for (const auto &value : data)
+    {
+        if (!(std::fabs(value) < limit) || decode(encode(value)) != value)
+            return false;
+    }
+    return true;
+}
+
+QVector<double> FixedPointSample::toDoubles() const
+{
+    QVector<double> result(_values.size());
+    for (int i = 0; i < _values.size(); i++)
+        result[i] = decode(_values[i]);
+    return result;
+}
+
+qint64 FixedPointSample::sum() const
+{
+    qint64 result = 0;
+    for (const auto &value : _values)
+        result += value;
+    return result;
+}
+
+QVector<int> FixedPointSample::histogram(int bins) const
+{
+    QVector<int> hist(bins, 0);
+    if (_values.isEmpty() || bins <= 0)
+        return hist;
+
+    // Границы интервалов считаются в double так же, как для выборки double,
+    // и переводятся в целые пороги: значение попадает в первый интервал,
+    // верхний порог которого не меньше него, значения выше последнего порога -
+    // в последний интервал.
+    const double min = decode(_min);
+    const double delta = (decode(_max) - min) / bins;
+
+    QVector<qint64> thresholds(bins);
+    for (int i = 0; i < bins; i++)
+        thresholds[i] = upperThreshold(min + (i + 1) * delta);
+
+    const qint64 range = static_cast<qint64>(_max) - _min;
+    for (const auto &value : _values)
+    {
+        int index = range > 0 ? static_cast<int>((value - _min) * bins / range) : 0;
+        index = std::min(index, bins - 1);
+        while (index > 0 && value <= thresholds[index - 1])
+            index--;
+        while (index < bins - 1 && value > thresholds[index])
+            index++;
+
+        hist[index]++;
+    }
+    return hist;
+}
+
+QVector<qint32> FixedPointSample::sorted() const
+{
+    QVector<quint32> keys(_values.size());
+    for (int i = 0; i < _values.size(); i++)
+        keys[i] = static_cast<quint32>(_values[i]) ^ 0x80000000u;
+
+    // Распределение по корзинам идет через сырые указатели: неконстантный
+    // operator[] у QVector проверяет необходимость отсоединения на каждом обращении.
+    QVector<quint32> buffer(keys.size());
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int counts[257] = {};
+        const quint32 *source = keys.constData();
+        quint32 *target = buffer.data();
+        for (int i = 0; i < keys.size(); i++)
+            counts[((source[i] >> shift) & 0xFF) + 1]++;
+        for (int i = 0; i < 256; i++)
+            counts[i + 1] += counts[i];
+        for (int i = 0; i < keys.size(); i++)
+            target[counts[(source[i] >> shift) & 0xFF]++] = source[i];
+        keys.swap(buffer);
+    }
+
+    QVector<qint32> result(keys.size());
+    for (int i = 0; i < keys.size(); i++)
+        result[i] = static_cast<qint32>(keys[i] ^ 0x80000000u);
+    return result;
+}
+
+FixedPointSample FixedPointSample::load(const QString &filePath)
+{
+    FixedPointSample result;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+
+    FileHeader header;
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+        || header.signature != fileSignature || header.decimals != decimals)
+    {
+        qDebug() << "Unexpected fixed-point cache header:" << filePath;
+        return result;
+    }
+
+    // Размер из заголовка должен помещаться в QVector и совпадать с длиной файла.
+    const qint64 payload = file.size() - static_cast<qint64>(sizeof(header));
+    if (header.count > static_cast<quint64>(std::numeric_limits<int>::max())
+        || header.count * sizeof(qint32) != static_cast<quint64>(payload))
+    {
+        qDebug() << "Fixed-point cache size does not match its header:" << filePath;
+        return result;
+    }
+
+    QVector<qint32> values(static_cast<int>(header.count));
+    qint64 bytes = static_cast<qint64>(values.size()) * sizeof(qint32);
+    if (file.read(reinterpret_cast<char *>(values.data()), bytes) != bytes)
+    {
+        qDebug() << "Fixed-point cache is truncated:" << filePath;
+        return result;
+    }
+
+    result._values = values;
+    if (!values.isEmpty())
+    {
+        auto min_max = std::minmax_element(values.begin(), values.end());
+        result._min = *min_max.first;
+        result._max = *min_max.second;
+    }
+    return result;
+}
+
+bool FixedPointSample::save(const QString &filePath) const
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Failed to open file for writing:" << filePath << file.errorString();
+        return false;
+    }
+
+    FileHeader header = {fileSignature, decimals, static_cast<quint64>(_values.size())};
+    qint64 bytes = static_cast<qint64>(_values.size()) * sizeof(qint32);
+    return file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header)
+           && file.write(reinterpret_cast<const char *>(_values.constData()), bytes) == bytes;
+}
@@ -0,0 +1,83 @@
+#ifndef FIXEDPOINTSAMPLE_H
+#define FIXEDPOINTSAMPLE_H
+
+#include <QVector>
+#include <QString>
+#include <algorithm>
+
+/**
+ * @brief Выборка в формате с фиксированной точкой.
+ * @details Генераторы округляют значения до decimals знаков, поэтому выборка
+ * без потерь хранится как int32, умноженный на scale: вдвое меньше памяти,
+ * чем QVector<double>. Гистограмма, суммы и сортировка (поразрядная)
+ * выполняются над целыми без перевода в double.
+ */
+class FixedPointSample
+{
+public:
+    static constexpr int decimals = 5;
+    static constexpr qint32 scale = 100000;
+
+    FixedPointSample() = default;
+    explicit FixedPointSample(const QVector<double> &data);
+
+    /**
+     * Проверяет, что все значения точно восстанавливаются из int32.
+     */
+    static bool isRepresentable(const QVector<double> &data);
+
+    static double decode(qint32 raw) { return raw / static_cast<double>(scale); }
+
+    int size() const { return _values.size(); }
+    bool isEmpty() const { return _values.isEmpty(); }
+    const QVector<qint32> &values() const { return _values; }
+    QVector<double> toDoubles() const;
+
+    qint32 minimum() const { return _min; }
+    qint32 maximum() const { return _max; }
+    qint64 sum() const;
+
+    /**
+     * Гистограмма на bins интервалов с теми же границами, что у
+     * CalcUnit::createHistogramSet для декодированной выборки.
+     */
+    QVector<int> histogram(int bins) const;
+
+    /**
+     * Обход значений, раскодированных в double блоками фиксированного размера,
+     * без копии всей выборки: visitor(const double *values, int count).
+     */
+    template <typename Visitor>
+    void forEachBlock(Visitor visitor) const
+    {
+        double buffer[blockSize];
+        for (int i = 0; i < _values.size(); i += blockSize)
+        {
+            int count = std::min(blockSize, _values.size() - i);
+            for (int j = 0; j < count; j++)
+                buffer[j] = decode(_values[i + j]);
+            visitor(static_cast<const double *>(buffer), count);
+        }
+    }
+
+    /**
+     * Значения, упорядоченные поразрядной сортировкой за четыре прохода.
+     */
+    QVector<qint32> sorted() const;
+
+    /**
+     * Файл кэша: заголовок (сигнатура, число знаков, размер) и значения int32
+     * в порядке байтов машины. При ошибке возвращается пустая выборка.
+     */
+    static FixedPointSample load(const QString &filePath);
+    bool save(const QString &filePath) const;
+
+private:
+    static constexpr int blockSize = 4096;
+
+    QVector<qint32> _values;
+    qint32 _min = 0;
+    qint32 _max = 0;
+};
+
+#endif // FIXEDPOINTSAMPLE_H
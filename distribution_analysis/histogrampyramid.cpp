@@ -0,0 +1,78 @@
+#include "histogrampyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+HistogramPyramid::HistogramPyramid(const QVector<double> &data)
+{
+    if (data.isEmpty())
+        return;
+
+    auto min_max = std::minmax_element(data.begin(), data.end());
+    _min = *min_max.first;
+    _max = *min_max.second;
+    build([&data](const std::function<void(const double *, int)> &visitor)
+    {
+        visitor(data.constData(), data.size());
+    });
+}
+
+HistogramPyramid::HistogramPyramid(const SampleShard &sample, double minimum, double maximum) :
+    _min(minimum),
+    _max(maximum)
+{
+    build(sample);
+}
+
+void HistogramPyramid::build(const SampleShard &sample)
+{
+    const double range = _max - _min;
+    QVector<int> finest(finestBins, 0);
+    sample([this, range, &finest](const double *values, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            int index = range > 0 ? static_cast<int>((values[i] - _min) / range * finestBins) : 0;
+            finest[std::max(0, std::min(index, finestBins - 1))]++;
+        }
+    });
+    _levels.append(finest);
+
+    while (_levels.last().size() > 1)
+    {
+        const auto &previous = _levels.last();
+        QVector<int> level(previous.size() / 2);
+        for (int i = 0; i < level.size(); i++)
+            level[i] = previous[2 * i] + previous[2 * i + 1];
+        _levels.append(level);
+    }
+}
+
+HistogramSlice HistogramPyramid::slice(double from, double to, int maxBins) const
+{
+    HistogramSlice result;
+    if (_levels.isEmpty())
+        return result;
+
+    from = std::max(from, _min);
+    to = std::min(to, _max);
+    double range = _max - _min;
+
+    for (const auto &level : _levels)
+    {
+        double width = range / level.size();
+        int first = width > 0 ? static_cast<int>(std::floor((from - _min) / width)) : 0;
+        int last = width > 0 ? static_cast<int>(std::ceil((to - _min) / width)) : 1;
+        first = std::max(0, std::min(first, level.size() - 1));
+        last = std::max(first + 1, std::min(last, level.size()));
+
+        if (last - first > maxBins && level.size() > 1)
+            continue;
+
+        result.start = _min + first * width;
+        result.binWidth = width;
+        result.counts = level.mid(first, last - first);
+        break;
+    }
+    return result;
+}
@@ -0,0 +1,253 @@
+#include "kerneldensity.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <QtMath>
+
+namespace
+{
+/// Ядро обрезается на этом числе ширин окна, отброшенный вес меньше 10^-6.
+constexpr double kernelSupport = 5.0;
+
+using Complex = std::complex<double>;
+
+/// Итеративное БПФ по основанию 2, размер - степень двойки.
+void fft(std::vector<Complex> &values, bool inverse)
+{
+    const int size = static_cast<int>(values.size());
+    for (int i = 1, j = 0; i < size; i++)
+    {
+        int bit = size >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(values[i], values[j]);
+    }
+
+    // Корни считаются напрямую, а не умножением, чтобы ошибка не копилась.
+    std::vector<Complex> roots(size / 2);
+    const double sign = inverse ? 1.0 : -1.0;
+    for (int k = 0; k < size / 2; k++)
+        roots[k] = std::polar(1.0, sign * 2.0 * M_PI * k / size);
+
+    for (int length = 2; length <= size; length <<= 1)
+    {
+        const int half = length / 2;
+        const int stride = size / length;
+        for (int i = 0; i < size; i += length)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                Complex odd = values[i + k + half] * roots[k * stride];
+                values[i + k + half] = values[i + k] - odd;
+                values[i + k] += odd;
+            }
+        }
+    }
+
+    if (inverse)
+    {
+        for (auto &value : values)
+            value /= size;
+    }
+}
+
+/// Квантиль по весам сетки, вес точки считается равномерно размазанным по шагу.
+double gridQuantile(const QVector<double> &weights, double total, double start, double step, double probability)
+{
+    const double target = probability * total;
+    double below = 0.0;
+    for (int i = 0; i < weights.size(); i++)
+    {
+        if (weights[i] > 0 && below + weights[i] >= target)
+            return start + (i - 0.5 + (target - below) / weights[i]) * step;
+        below += weights[i];
+    }
+    return start + (weights.size() - 1) * step;
+}
+}
+
+KernelDensity::KernelDensity(const QVector<double> &data, int gridSize)
+{
+    TRACE_SPAN("KernelDensity::KernelDensity");
+    build(data.constData(), data.size(), gridSize);
+}
+
+KernelDensity::KernelDensity(const QVector<float> &data, int gridSize)
+{
+    TRACE_SPAN("KernelDensity::KernelDensity");
+    build(data.constData(), data.size(), gridSize);
+}
+
+KernelDensity::KernelDensity(const SampleShard &sample, double minimum, double maximum, int gridSize)
+{
+    TRACE_SPAN("KernelDensity::KernelDensity");
+    prepareGrid(minimum, maximum, gridSize);
+    sample([this](const double *values, int count) { addLinear(values, count); });
+    estimate();
+}
+
+KernelDensity::KernelDensity(const QVector<qint64> &counts, double minimum, double maximum)
+{
+    TRACE_SPAN("KernelDensity::KernelDensity");
+    if (counts.isEmpty())
+        return;
+
+    _step = (maximum - minimum) / counts.size();
+    _start = minimum + _step / 2;
+    _weights.resize(counts.size());
+    for (int i = 0; i < counts.size(); i++)
+    {
+        _weights[i] = counts[i];
+        _count += counts[i];
+    }
+    estimate();
+}
+
+double KernelDensity::silvermanBandwidth(double deviation, double interquartileRange, double count)
+{
+    double spread = interquartileRange > 0 ? std::min(deviation, interquartileRange / 1.34) : deviation;
+    return count > 0 ? 0.9 * spread * std::pow(count, -0.2) : 0.0;
+}
+
+template<typename T>
+void KernelDensity::build(const T *values, int count, int gridSize)
+{
+    if (count == 0)
+        return;
+
+    auto minMax = std::minmax_element(values, values + count);
+    prepareGrid(*minMax.first, *minMax.second, gridSize);
+    addLinear(values, count);
+    estimate();
+}
+
+void KernelDensity::prepareGrid(double minimum, double maximum, int gridSize)
+{
+    _start = minimum;
+    _step = maximum > minimum ? (maximum - minimum) / (gridSize - 1) : 0.0;
+    _weights.fill(0.0, _step > 0 ? gridSize : 1);
+}
+
+template<typename T>
+void KernelDensity::addLinear(const T *values, int count)
+{
+    const int last = _weights.size() - 1;
+    double *weights = _weights.data();
+    _count += count;
+
+    if (last == 0)
+    {
+        weights[0] += count;
+        return;
+    }
+
+    // Значение делит единичный вес между двумя соседними точками сетки
+    // пропорционально близости, так сохраняются сумма и среднее.
+    const double scale = 1.0 / _step;
+    for (int i = 0; i < count; i++)
+    {
+        double position = std::clamp((values[i] - _start) * scale, 0.0, static_cast<double>(last));
+        int index = std::min(static_cast<int>(position), last - 1);
+        double fraction = position - index;
+        weights[index] += 1.0 - fraction;
+        weights[index + 1] += fraction;
+    }
+}
+
+void KernelDensity::estimate()
+{
+    TRACE_SPAN("KernelDensity::estimate");
+    const int size = _weights.size();
+    if (_count == 0 || size < 2 || _step <= 0)
+    {
+        _density = size == 1 && _count > 0 ? QVector<double>(1, 1.0) : QVector<double>();
+        _weights.clear();
+        return;
+    }
+
+    double mean = 0.0;
+    for (int i = 0; i < size; i++)
+        mean += _weights[i] * (_start + i * _step);
+    mean /= _count;
+
+    double dispersion = 0.0;
+    for (int i = 0; i < size; i++)
+        dispersion += _weights[i] * std::pow(_start + i * _step - mean, 2);
+    dispersion = _count > 1 ? dispersion / (_count - 1) : 0.0;
+
+    double interquartileRange = gridQuantile(_weights, _count, _start, _step, 0.75)
+                                - gridQuantile(_weights, _count, _start, _step, 0.25);
+    _bandwidth = silvermanBandwidth(std::sqrt(dispersion), interquartileRange, _count);
+    if (_bandwidth <= 0)
+        _bandwidth = _step;
+
+    // Линейная свертка через круговую: размер БПФ не меньше сетки плюс
+    // половина ядра, иначе хвосты ядра заворачиваются на другой край.
+    const int reach = static_cast<int>(std::min<double>(std::ceil(kernelSupport * _bandwidth / _step), size - 1));
+    int fftSize = 1;
+    while (fftSize < size + reach)
+        fftSize <<= 1;
+
+    std::vector<Complex> weights(fftSize);
+    for (int i = 0; i < size; i++)
+        weights[i] = _weights[i];
+
+    std::vector<Complex> kernel(fftSize);
+    const double norm = 1.0 / (_count * _bandwidth * std::sqrt(2.0 * M_PI));
+    for (int l = 0; l <= reach; l++)
+    {
+        double value = norm * std::exp(-0.5 * std::pow(l * _step / _bandwidth, 2));
+        kernel[l] = value;
+        if (l > 0)
+            kernel[fftSize - l] = value;
+    }
+
+    fft(weights, false);
+    fft(kernel, false);
+    for (int i = 0; i < fftSize; i++)
+        weights[i] *= kernel[i];
+    fft(weights, true);
+
+    _density.resize(size);
+    for (int i = 0; i < size; i++)
+        _density[i] = std::max(0.0, weights[i].real());
+    _weights.clear();
+}
+
+double KernelDensity::valueAt(double x) const
+{
+    if (_density.size() < 2)
+        return 0.0;
+
+    double position = (x - _start) / _step;
+    if (position < 0 || position > _density.size() - 1)
+        return 0.0;
+
+    int index = std::min(static_cast<int>(position), _density.size() - 2);
+    double fraction = position - index;
+    return _density[index] * (1.0 - fraction) + _density[index + 1] * fraction;
+}
+
+double KernelDensity::mode() const
+{
+    if (_density.isEmpty())
+        return _start;
+
+    int index = std::max_element(_density.begin(), _density.end()) - _density.begin();
+    double offset = 0.0;
+    if (index > 0 && index < _density.size() - 1)
+    {
+        double left = _density[index - 1];
+        double center = _density[index];
+        double right = _density[index + 1];
+        double curvature = left - 2 * center + right;
+        if (curvature < 0)
+            offset = 0.5 * (left - right) / curvature;
+    }
+    return _start + (index + offset) * _step;
+}
@@ -1,10 +1,111 @@
 #include "mainwidget.h"
+#include "tracing.h"
+#include "allocationpanel.h"
+#include "perfgate.h"
 #include <QApplication>
+#include <QTextStream>
+
+#include <cmath>
+
+namespace
+{
+QVector<PerfGate::Scenario> perfScenarios()
+{
+    // Виртуальные выборки не зависят от файлов и одинаковы на любой машине.
+    auto unit = QSharedPointer<CalcUnit>::create(15, StorageMode::Virtual);
+    return {{"four_datasets", [unit]()
+    {
+        for (int i = 0; i < 20; i++)
+            for (int dataSize : {100, 1000})
+                for (bool gauss : {false, true})
+                    for (int ranges : {5, 7})
+                        MainWindow::computeView(*unit, dataSize, gauss, ranges);
+    }}};
+}
+
+/**
+ * Расчет виртуальной выборки по участкам против расчета в памяти по той же
+ * выборке: медиана и мода должны совпадать точно, моменты - с точностью до округления.
+ */
+int runShardVerification()
+{
+    CalcUnit unit(15, StorageMode::Virtual);
+    QTextStream out(stdout);
+    out << "size\tlaw\tranges\tshards\tmedian\tmode\tmax_moment_error\n";
+
+    bool passed = true;
+    for (qint64 size : {1000, 100001, 2000000})
+    {
+        for (bool gauss : {false, true})
+        {
+            const auto data = unit.virtualElements(size, gauss);
+            const auto values = data.slice(0, size);
+            for (int ranges : {5, 7})
+            {
+                const auto expected = unit.calculateStatistics(values, ranges);
+                for (int shards : {1, 7})
+                {
+                    const auto actual = unit.calculateStatistics(CalcUnit::virtualShards(data, shards), ranges);
+
+                    double error = 0.0;
+                    for (const auto &pair : {std::make_pair(actual.expectedValue, expected.expectedValue),
+                                             std::make_pair(actual.dispersion, expected.dispersion),
+                                             std::make_pair(actual.standardDeviation, expected.standardDeviation)})
+                        error = std::max(error, std::abs(pair.first - pair.second) / std::max(std::abs(pair.second), 1.0));
+
+                    const bool medianMatches = actual.median == expected.median;
+                    const bool modeMatches = actual.modeValue == expected.modeValue;
+                    passed = passed && medianMatches && modeMatches && error <= 1e-12;
+
+                    out << size << '\t' << (gauss ? "gauss" : "uniform") << '\t' << ranges << '\t' << shards << '\t'
+                        << (medianMatches ? "ok" : "differs") << '\t' << (modeMatches ? "ok" : "differs") << '\t'
+                        << error << '\n';
+                }
+            }
+        }
+    }
+    return passed ? 0 : 1;
+}
+}
 
 int main(int argc, char *argv[]) {
+    // DATAANALYS_TRACE=<файл>: запись трассировки в формате Chrome trace при выходе
+    Tracing::enableFromEnvironment();
+    // DATAANALYS_ALLOC_STATS=1: учет памяти по этапам, панель по F12
+    AllocationStats::enableFromEnvironment();
+
+    // --perf-gate <база> / --perf-baseline <база>: проверка производительности без интерфейса
+    if (PerfGate::isRequested(argc, argv))
+    {
+        QCoreApplication app(argc, argv);
+        return PerfGate::run(argc, argv, perfScenarios());
+    }
+
+    // --verify-shards: сравнение расчета по участкам с расчетом в памяти
+    for (int i = 1; i < argc; i++)
+    {
+        if (QString(argv[i]) == "--verify-shards")
+        {
+            QCoreApplication app(argc, argv);
+            return runShardVerification();
+        }
+    }
+
     QApplication app(argc, argv);
 
-    MainWindow main;
+    // --compact: выборки и кэш в формате с фиксированной точкой
+    // --virtual: выборки порождаются по запросу без файлов
+    // --float: выборки хранятся и обрабатываются во float
+    auto storageMode = StorageMode::Text;
+    if (app.arguments().contains("--compact"))
+        storageMode = StorageMode::Compact;
+    else if (app.arguments().contains("--virtual"))
+        storageMode = StorageMode::Virtual;
+    else if (app.arguments().contains("--float"))
+        storageMode = StorageMode::Float;
+
+    MainWindow main(nullptr, storageMode);
+    AllocationPanel::install(&main);
     main.show();
 
     return app.exec();
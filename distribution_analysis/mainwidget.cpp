@@ -1,6 +1,9 @@
 #include "mainwidget.h"
 
+#include "backgroundtask.h"
 #include "chartview.h"
+#include "histogrampyramid.h"
+#include "tracing.h"
 #include "qboxlayout.h"
 #include "qgroupbox.h"
 #include "qvalueaxis.h"
@@ -9,11 +12,29 @@
 #include "qbarcategoryaxis.h"
 #include "qlabel.h"
 #include "QTabWidget"
+#include <QSpinBox>
 #include <QLineSeries>
 
 using namespace QtCharts;
 
-MainWindow::MainWindow(QWidget *parent)
+namespace
+{
+/// Середина самого наполненного интервала гистограммы на [minimum, maximum].
+double histogramMode(const QVector<int> &hist, double minimum, double maximum)
+{
+    if (hist.isEmpty())
+        return 0.0;
+
+    int maxIndex = std::max_element(hist.begin(), hist.end()) - hist.begin();
+    double delta = (maximum - minimum) / hist.size();
+    double start_x = minimum + maxIndex * delta;
+    double end_x = minimum + (maxIndex + 1) * delta;
+
+    return (start_x + end_x) / 2;
+}
+}
+
+MainWindow::MainWindow(QWidget *parent, StorageMode storageMode)
     : QWidget(parent)
 {
     int l1 = 100;
@@ -29,12 +50,12 @@ MainWindow::MainWindow(QWidget *parent)
     auto tab_rand = new QWidget(this);
     auto layout_rand = new QVBoxLayout(tab_rand);
     auto layout_hund = new QHBoxLayout(tab_rand);
-    layout_hund->addWidget(createWidget(l1, false, q1));
-    layout_hund->addWidget(createWidget(l1, false, q2));
+    addCell(layout_hund, l1, false, q1);
+    addCell(layout_hund, l1, false, q2);
 
     auto layout_thus = new QHBoxLayout(tab_rand);
-    layout_thus->addWidget(createWidget(l2, false, q1));
-    layout_thus->addWidget(createWidget(l2, false, q2));
+    addCell(layout_thus, l2, false, q1);
+    addCell(layout_thus, l2, false, q2);
 
     layout_rand->addLayout(layout_hund);
     layout_rand->addLayout(layout_thus);
@@ -44,12 +65,12 @@ MainWindow::MainWindow(QWidget *parent)
     auto tab_gauss = new QWidget();
     auto layout_gauss = new QVBoxLayout(tab_gauss);
     auto layout_gauss_hund = new QHBoxLayout(tab_rand);
-    layout_gauss_hund->addWidget(createWidget(l1, true, q1));
-    layout_gauss_hund->addWidget(createWidget(l1, true, q2));
+    addCell(layout_gauss_hund, l1, true, q1);
+    addCell(layout_gauss_hund, l1, true, q2);
 
     auto layout_gauss_thus = new QHBoxLayout(tab_rand);
-    layout_gauss_thus->addWidget(createWidget(l2, true, q1));
-    layout_gauss_thus->addWidget(createWidget(l2, true, q2));
+    addCell(layout_gauss_thus, l2, true, q1);
+    addCell(layout_gauss_thus, l2, true, q2);
 
     layout_gauss->addLayout(layout_gauss_hund);
     layout_gauss->addLayout(layout_gauss_thus);
@@ -62,16 +83,115 @@ MainWindow::MainWindow(QWidget *parent)
 
     setMinimumHeight(800);
     setMinimumWidth(1350);
+
+    // Выборки загружаются, а характеристики считаются в фоне, окно сразу
+    // показывается с заглушками, которые заменяются по мере готовности.
+    runInBackground(this, [storageMode]() { return QSharedPointer<CalcUnit>::create(15, storageMode); },
+                    [this](const QSharedPointer<CalcUnit> &unit)
+    {
+        _unit = unit;
+        for (const auto &cell : qAsConst(_pendingCells))
+        {
+            runInBackground(this, [unit, cell]() { return computeView(*unit, cell.dataSize, cell.gauss, cell.ranges); },
+                            [this, cell](const HistogramView &view)
+            {
+                auto widget = createWidget(view, cell.dataSize, cell.ranges);
+                delete cell.layout->replaceWidget(cell.placeholder, widget);
+                cell.placeholder->deleteLater();
+            });
+        }
+        _pendingCells.clear();
+    });
 }
 
-QWidget *MainWindow::createWidget(int dataSize, bool gauss, int ranges)
+void MainWindow::addCell(QBoxLayout *layout, int dataSize, bool gauss, int ranges)
 {
-    QVector<double> data;
-    if (gauss)
-        data = _unit.gaussElements(dataSize);
+    auto placeholder = new QLabel("Вычисление...", this);
+    placeholder->setAlignment(Qt::AlignCenter);
+    layout->addWidget(placeholder);
+
+    _pendingCells.append({layout, placeholder, dataSize, gauss, ranges});
+}
+
+HistogramView MainWindow::computeView(const CalcUnit &unit, int dataSize, bool gauss, int ranges)
+{
+    TRACE_SPAN("MainWindow::computeView");
+    auto compact = unit.compactElements(dataSize, gauss);
+    auto floats = unit.floatElements(dataSize, gauss);
+
+    HistogramView view;
+    if (unit.storageMode() == StorageMode::Virtual)
+    {
+        // Виртуальная выборка не переводится в QVector<double>: характеристики
+        // считаются по участкам параллельно, гистограмма, пирамида и плотность -
+        // потоковыми проходами.
+        view.data = unit.virtualElements(dataSize, gauss);
+        const auto &data = view.data;
+        const SampleShard shard = [&data](const std::function<void(const double *, int)> &visitor)
+        {
+            data.forEachBlock(visitor);
+        };
+        double minimum = std::numeric_limits<double>::max();
+        double maximum = std::numeric_limits<double>::lowest();
+        data.forEachBlock([&minimum, &maximum](const double *values, int count)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                minimum = std::min(minimum, values[i]);
+                maximum = std::max(maximum, values[i]);
+            }
+        });
+
+        view.pyramid = QSharedPointer<HistogramPyramid>::create(shard, minimum, maximum);
+        view.density = QSharedPointer<KernelDensity>::create(shard, minimum, maximum);
+        view.stats = unit.calculateStatistics(data, ranges);
+        // Мода плотности по эскизу заменяется модой построенной оценки, чтобы совпадала с кривой.
+        view.stats.densityMode = view.density->mode();
+        view.hist = unit.createHistogramSet(data, ranges);
+        return view;
+    }
+
+    if (!compact.isEmpty())
+    {
+        // Выборка с фиксированной точкой не переводится в QVector<double>:
+        // пирамида и плотность обходят её блоками.
+        const SampleShard shard = [&compact](const std::function<void(const double *, int)> &visitor)
+        {
+            compact.forEachBlock(visitor);
+        };
+        const double minimum = FixedPointSample::decode(compact.minimum());
+        const double maximum = FixedPointSample::decode(compact.maximum());
+
+        view.sample = QSharedPointer<BinnedSample>::create(compact.sorted(), FixedPointSample::scale);
+        view.pyramid = QSharedPointer<HistogramPyramid>::create(shard, minimum, maximum);
+        view.density = QSharedPointer<KernelDensity>::create(shard, minimum, maximum);
+        view.stats = unit.calculateStatistics(compact, ranges, *view.density);
+    }
+    else if (!floats.isEmpty())
+    {
+        // Характеристики и плотность считаются по float, упорядоченной выборке
+        // и пирамиде нужна копия в double.
+        const QVector<double> widened(floats.cbegin(), floats.cend());
+        view.sample = QSharedPointer<BinnedSample>::create(widened);
+        view.pyramid = QSharedPointer<HistogramPyramid>::create(widened);
+        view.density = QSharedPointer<KernelDensity>::create(floats);
+        view.stats = unit.calculateStatistics(floats, ranges, *view.density);
+    }
     else
-        data = _unit.uniformElements(dataSize);
+    {
+        auto data = gauss ? unit.gaussElements(dataSize) : unit.uniformElements(dataSize);
+        view.sample = QSharedPointer<BinnedSample>::create(data);
+        view.pyramid = QSharedPointer<HistogramPyramid>::create(data);
+        view.density = QSharedPointer<KernelDensity>::create(data);
+        view.stats = unit.calculateStatistics(data, ranges, *view.density);
+    }
+    view.hist = view.sample->histogram(ranges);
+    return view;
+}
 
+QWidget *MainWindow::createWidget(const HistogramView &view, int dataSize, int ranges)
+{
+    TRACE_SPAN("MainWindow::createWidget");
     auto wgt = new QWidget(this);
     auto wgt_layout = new QHBoxLayout(this);
 
@@ -82,8 +202,34 @@ QWidget *MainWindow::createWidget(int dataSize, bool gauss, int ranges)
     auto state_layout = new QVBoxLayout(this);
 
     auto name = QString("Выборка: %1 на %2 диапазонов");
-    graph_layout->addWidget(createView(name.arg(dataSize).arg(ranges), data, ranges));
-    state_layout->addWidget(createStatWidget(data, ranges));
+    auto chart_view = createView(name.arg(dataSize).arg(ranges), view, ranges);
+    auto stat_widget = createStatWidget(view.stats);
+    graph_layout->addWidget(chart_view);
+    state_layout->addWidget(stat_widget);
+
+    auto ranges_box = new QSpinBox(this);
+    ranges_box->setRange(minRanges, maxRanges);
+    ranges_box->setValue(ranges);
+    ranges_box->setPrefix("Интервалов: ");
+    state_layout->addWidget(ranges_box);
+
+    // Смена числа интервалов пересчитывает гистограмму по отсортированной
+    // выборке без повторного просмотра данных, виртуальная выборка
+    // просматривается заново потоковым проходом.
+    auto mode_label = stat_widget->findChild<QLabel *>("mode");
+    auto sample = view.sample;
+    auto data = view.data;
+    auto pyramid = view.pyramid;
+    auto unit = _unit;
+    connect(ranges_box, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            [chart_view, mode_label, sample, data, pyramid, unit, name, dataSize](int bins)
+    {
+        auto hist = sample ? sample->histogram(bins) : unit->createHistogramSet(data, bins);
+        double mode = sample ? sample->mode(bins) : histogramMode(hist, pyramid->minimum(), pyramid->maximum());
+        chart_view->setBaseHistogram(hist);
+        chart_view->chart()->setTitle(name.arg(dataSize).arg(bins));
+        mode_label->setText("Мода: \n" + QString::number(mode));
+    });
 
     group_graph->setLayout(graph_layout);
     group_state->setLayout(state_layout);
@@ -96,11 +242,12 @@ QWidget *MainWindow::createWidget(int dataSize, bool gauss, int ranges)
     return wgt;
 }
 
-QChartView * MainWindow::createView(const QString & name, const QVector<double> &data, int histCount)
+ChartView * MainWindow::createView(const QString & name, const HistogramView &view, int histCount)
 {
+    TRACE_SPAN("MainWindow::createView");
     auto set = new QBarSet("Гистограмма");
 
-    auto  hist = _unit.createHistogramSet(data, histCount);
+    const auto &hist = view.hist;
 
     for (int i = 0; i < histCount; ++i)
         *set << hist[i];
@@ -112,8 +259,6 @@ QChartView * MainWindow::createView(const QString & name, const QVector<double>
     auto lineSeries = new QLineSeries();
     lineSeries->setPen(QPen(Qt::red));
     lineSeries->setName("Кривая распределения");
-    for (int i = 0; i < histCount; ++i)
-        lineSeries->append(i, hist[i]);
 
     auto chart = new QChart();
     chart->addSeries(series);
@@ -131,9 +276,7 @@ QChartView * MainWindow::createView(const QString & name, const QVector<double>
     lineSeries->attachAxis(axisX);
 
     auto axisXData = new QValueAxis();
-    auto minElement = *std::min_element(data.begin(), data.end());
-    auto maxElement = *std::max_element(data.begin(), data.end());
-    axisXData->setRange(minElement, maxElement);
+    axisXData->setRange(view.pyramid->minimum(), view.pyramid->maximum());
     axisXData->setTickCount(histCount + 1);
     chart->addAxis(axisXData, Qt::AlignBottom);
 
@@ -146,28 +289,30 @@ QChartView * MainWindow::createView(const QString & name, const QVector<double>
     chart_view->setRenderHint(QPainter::Antialiasing);
     chart_view->setRubberBand(QChartView::RectangleRubberBand);
     chart_view->setInteractive(true);
+    chart_view->setHistogram(view.pyramid, set, axisX, axisXData, lineSeries, view.density);
 
     return chart_view;
 }
 
-QWidget *MainWindow::createStatWidget(const QVector<double> &data, int size)
+QWidget *MainWindow::createStatWidget(const Statistics &stats)
 {
     auto stat_widget = new QWidget(this);
     auto stat_layout = new QVBoxLayout(stat_widget);
 
-    auto stats = _unit.calculateStatistics(data, size);
-
     auto exp_value_label = createCenteredLabel("Математическое \nожидание: \n", stats.expectedValue, stat_widget);
     auto dispersion_label = createCenteredLabel("Дисперсия: \n", stats.dispersion, stat_widget);
     auto median_label = createCenteredLabel("Медиана: \n", stats.median, stat_widget);
     auto mode_label = createCenteredLabel("Мода: \n", stats.modeValue, stat_widget);
+    mode_label->setObjectName("mode");
     auto std_dev_label = createCenteredLabel("Среднее \nквадратическое  \nотклонение: \n", stats.standardDeviation, stat_widget);
+    auto density_mode_label = createCenteredLabel("Мода по оценке \nплотности: \n", stats.densityMode, stat_widget);
 
     stat_layout->addWidget(exp_value_label);
     stat_layout->addWidget(dispersion_label);
     stat_layout->addWidget(median_label);
     stat_layout->addWidget(mode_label);
     stat_layout->addWidget(std_dev_label);
+    stat_layout->addWidget(density_mode_label);
 
     stat_widget->setLayout(stat_layout);
 
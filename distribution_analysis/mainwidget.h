@@ -2,29 +2,63 @@
 #define MAIN_WINDOW_H
 
 #include "calcunit.h"
+#include "binnedsample.h"
+#include "histogrampyramid.h"
+#include "kerneldensity.h"
 #include <QWidget>
+#include <QSharedPointer>
 
 class QLabel;
+class QBoxLayout;
+class ChartView;
 
 namespace QtCharts { class QChartView; class QLineSeries; class QChart; class QValueAxis;}
 
+struct HistogramView
+{
+    QVector<int> hist;                          ///< Гистограмма выборки
+    Statistics stats;                           ///< Характеристики выборки
+    QSharedPointer<HistogramPyramid> pyramid;   ///< Гистограмма для масштабирования
+    QSharedPointer<BinnedSample> sample;        ///< Выборка для смены числа интервалов
+    QSharedPointer<KernelDensity> density;      ///< Оценка плотности для кривой распределения
+    VirtualDataset data;                        ///< Порождаемая выборка, если sample не построен
+};
+
 class MainWindow : public QWidget {
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+    explicit MainWindow(QWidget *parent = nullptr, StorageMode storageMode = StorageMode::Text);
 
-    QWidget * createWidget(int dataSize, bool gauss, int ranges);
+    static constexpr int minRanges = 2;     ///< Наименьшее число интервалов гистограммы
+    static constexpr int maxRanges = 100;   ///< Наибольшее число интервалов гистограммы
 
-    QtCharts::QChartView * createView(const QString & name,
-                                      const QVector<double> &data,
+    QWidget * createWidget(const HistogramView &view, int dataSize, int ranges);
+
+    ChartView * createView(const QString & name,
+                                      const HistogramView &view,
                                      int histCount);
 
-    QWidget * createStatWidget(const QVector<double> &data, int size);
+    QWidget * createStatWidget(const Statistics &stats);
     QLabel *createCenteredLabel(const QString &text, double value, QWidget *parent);
 
+    static HistogramView computeView(const CalcUnit &unit, int dataSize, bool gauss, int ranges);
+
+private:
+    struct PendingCell
+    {
+        QBoxLayout *layout;
+        QWidget *placeholder;
+        int dataSize;
+        bool gauss;
+        int ranges;
+    };
+
+    void addCell(QBoxLayout *layout, int dataSize, bool gauss, int ranges);
+
 private:
-    CalcUnit _unit;
+    QSharedPointer<CalcUnit> _unit;
+    QVector<PendingCell> _pendingCells;
 };
 
 #endif // MAIN_WINDOW_H
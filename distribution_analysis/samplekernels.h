@@ -0,0 +1,218 @@
+#ifndef SAMPLEKERNELS_H
+#define SAMPLEKERNELS_H
+
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @brief Ядра расчета характеристик, обобщенные по типу значений выборки.
+ * @details Значения могут быть double или float: выборка во float вдвое меньше
+ * и быстрее читается из памяти, накопление всегда идет в double. Гистограмма
+ * и слагаемые x² дополнительно специализируются по числу интервалов: при
+ * известном на этапе компиляции числе границы и счетчики помещаются
+ * в регистры, а цикл по значениям не имеет ветвлений. Специализации есть
+ * для 5 и 7 интервалов, как в окнах программ; функции без числа интервалов
+ * в параметрах шаблона выбирают их во время выполнения.
+ */
+namespace SampleKernels
+{
+/// Наибольшее значение типа T, не превышающее bound: сравнение с ним совпадает со сравнением с bound.
+template<typename T>
+T boundBelow(double bound)
+{
+    T value = static_cast<T>(bound);
+    if (static_cast<double>(value) > bound)
+        value = std::nextafter(value, -std::numeric_limits<T>::infinity());
+    return value;
+}
+
+/**
+ * Гистограмма по правилу CalcUnit::createHistogramSet: значение относится к
+ * первому интервалу, верхняя граница которого не меньше него, значения выше
+ * последней границы из-за округления относятся к последнему интервалу. Числа
+ * попаданий добавляются к counts, так что выборку можно пройти блоками.
+ * Для каждой внутренней границы считается число не превышающих ее значений,
+ * гистограмма получается их разностями.
+ */
+template<int Bins, typename T>
+void histogram(const T *values, int count, double min, double max, int *counts)
+{
+    // Счетчик той же ширины, что и значение, чтобы маска сравнения складывалась без преобразований.
+    using Counter = typename std::conditional<sizeof(T) == 8, qint64, qint32>::type;
+
+    const double delta = (max - min) / Bins;
+    T bounds[Bins];
+    Counter notAbove[Bins] = {};
+    for (int i = 0; i < Bins - 1; i++)
+        bounds[i] = boundBelow<T>(min + (i + 1) * delta);
+
+    for (int j = 0; j < count; j++)
+    {
+        const T value = values[j];
+        for (int i = 0; i < Bins - 1; i++)
+            notAbove[i] += value <= bounds[i] ? 1 : 0;
+    }
+
+    // Последний интервал получает все остальное, в том числе значения выше округленной границы.
+    notAbove[Bins - 1] = count;
+    counts[0] += static_cast<int>(notAbove[0]);
+    for (int i = 1; i < Bins; i++)
+        counts[i] += static_cast<int>(notAbove[i] - notAbove[i - 1]);
+}
+
+/// То же для числа интервалов, известного во время выполнения. Без специализации номер интервала оценивается делением и уточняется по границам.
+template<typename T>
+void histogram(const T *values, int count, double min, double max, int bins, int *counts)
+{
+    switch (bins)
+    {
+    case 5:
+        return histogram<5>(values, count, min, max, counts);
+    case 7:
+        return histogram<7>(values, count, min, max, counts);
+    }
+
+    const double delta = (max - min) / bins;
+    QVector<double> bounds(bins);
+    for (int i = 0; i < bins; i++)
+        bounds[i] = min + (i + 1) * delta;
+
+    for (int j = 0; j < count; j++)
+    {
+        const double value = values[j];
+        int index = delta > 0 ? std::min(static_cast<int>((value - min) / delta), bins - 1) : 0;
+        while (index > 0 && value <= bounds[index - 1])
+            index--;
+        while (index < bins - 1 && value > bounds[index])
+            index++;
+
+        counts[index]++;
+    }
+}
+
+/// Гистограмма выборки между ее крайними значениями.
+template<typename T>
+QVector<int> histogram(const T *values, int count, int bins)
+{
+    QVector<int> counts(bins, 0);
+    if (count == 0 || bins <= 0)
+        return counts;
+
+    auto minMax = std::minmax_element(values, values + count);
+    histogram(values, count, *minMax.first, *minMax.second, bins, counts.data());
+    return counts;
+}
+
+struct Moments
+{
+    double mean = 0.0;      ///< Среднее
+    double m2 = 0.0;        ///< Сумма квадратов отклонений от среднего
+    double m3 = 0.0;        ///< Сумма кубов отклонений
+    double m4 = 0.0;        ///< Сумма четвертых степеней отклонений
+};
+
+/**
+ * Среднее и суммы степеней отклонений до Order (2 или 4) за два прохода.
+ * Суммы ведутся в нескольких независимых накопителях, чтобы цикл не ждал
+ * результата предыдущего сложения.
+ */
+template<int Order, typename T>
+Moments moments(const T *values, int count)
+{
+    static_assert(Order == 2 || Order == 4, "Order must be 2 or 4");
+    constexpr int lanes = 4;
+
+    Moments result;
+    if (count == 0)
+        return result;
+
+    double sum[lanes] = {};
+    int j = 0;
+    for (; j + lanes <= count; j += lanes)
+    {
+        for (int k = 0; k < lanes; k++)
+            sum[k] += values[j + k];
+    }
+    for (; j < count; j++)
+        sum[0] += values[j];
+    result.mean = (sum[0] + sum[1] + (sum[2] + sum[3])) / count;
+
+    double m2[lanes] = {};
+    double m3[lanes] = {};
+    double m4[lanes] = {};
+    auto add = [&](int k, double value)
+    {
+        double diff = value - result.mean;
+        double square = diff * diff;
+        m2[k] += square;
+        if (Order == 4)
+        {
+            m3[k] += square * diff;
+            m4[k] += square * square;
+        }
+    };
+
+    for (j = 0; j + lanes <= count; j += lanes)
+    {
+        for (int k = 0; k < lanes; k++)
+            add(k, values[j + k]);
+    }
+    for (; j < count; j++)
+        add(0, values[j]);
+
+    result.m2 = m2[0] + m2[1] + (m2[2] + m2[3]);
+    result.m3 = m3[0] + m3[1] + (m3[2] + m3[3]);
+    result.m4 = m4[0] + m4[1] + (m4[2] + m4[3]);
+    return result;
+}
+
+/// Ожидаемое число N·pⱼ, квадрат отклонения и вклад интервала i в x².
+template<typename Round>
+inline double chiSquaredTerm(int i, const int *observed, const double *edgeProbabilities, double size,
+                             double *expected, double *squaredDeviations, double *terms, Round round)
+{
+    expected[i] = round(size * (edgeProbabilities[i + 1] - edgeProbabilities[i]), 4);
+    squaredDeviations[i] = round(std::pow(observed[i] - expected[i], 2), 5);
+    terms[i] = round(squaredDeviations[i] / expected[i], 4);
+    return terms[i];
+}
+
+/**
+ * Слагаемые x² по числам попаданий и значениям функции распределения на
+ * границах интервалов (Bins + 1 значение). round(value, digits) задает
+ * округление промежуточных значений, как в таблице расчета.
+ * @return Сумма вкладов.
+ */
+template<int Bins, typename Round>
+double chiSquaredTerms(const int *observed, const double *edgeProbabilities, double size,
+                       double *expected, double *squaredDeviations, double *terms, Round round)
+{
+    double total = 0.0;
+    for (int i = 0; i < Bins; i++)
+        total += chiSquaredTerm(i, observed, edgeProbabilities, size, expected, squaredDeviations, terms, round);
+    return total;
+}
+
+template<typename Round>
+double chiSquaredTerms(const int *observed, const double *edgeProbabilities, double size, int bins,
+                       double *expected, double *squaredDeviations, double *terms, Round round)
+{
+    switch (bins)
+    {
+    case 5:
+        return chiSquaredTerms<5>(observed, edgeProbabilities, size, expected, squaredDeviations, terms, round);
+    case 7:
+        return chiSquaredTerms<7>(observed, edgeProbabilities, size, expected, squaredDeviations, terms, round);
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < bins; i++)
+        total += chiSquaredTerm(i, observed, edgeProbabilities, size, expected, squaredDeviations, terms, round);
+    return total;
+}
+}
+
+#endif // SAMPLEKERNELS_H
@@ -0,0 +1,69 @@
+#ifndef VIRTUALDATASET_H
+#define VIRTUALDATASET_H
+
+#include <QVector>
+
+/**
+ * @brief Выборка, которая не хранится, а порождается по запросу.
+ * @details Хранятся только генератор, его параметры, начальное значение и
+ * размер. Отсчет с номером i получается из счетчикового генератора
+ * Philox4x32-10 по счетчику i, поэтому любой участок [from, to) порождается
+ * за O(to - from) без порождения предыдущих отсчетов и всегда одинаково.
+ * Значения округляются до 5 знаков, как у сохраняемых выборок.
+ */
+class VirtualDataset
+{
+public:
+    enum Generator
+    {
+        Uniform,    ///< Равномерное на [first, second]
+        Gauss       ///< Нормальное с мат. ожиданием first и СКО second
+    };
+
+    VirtualDataset() = default;
+    VirtualDataset(Generator generator, double first, double second,
+                   quint64 seed, qint64 size, double offset = 0.0);
+
+    qint64 size() const { return _size; }
+    bool isEmpty() const { return _size == 0; }
+
+    double at(qint64 index) const;
+
+    /// Порождает отсчеты [from, to) в output.
+    void generate(qint64 from, qint64 to, double *output) const;
+    QVector<double> slice(qint64 from, qint64 to) const;
+
+    /**
+     * Потоковый обход [from, to) блоками фиксированного размера без
+     * выделения памяти: visitor(const double *values, int count).
+     */
+    template <typename Visitor>
+    void forEachBlock(qint64 from, qint64 to, Visitor visitor) const
+    {
+        double buffer[blockSize];
+        for (qint64 i = from; i < to; i += blockSize)
+        {
+            int count = static_cast<int>(std::min<qint64>(blockSize, to - i));
+            generate(i, i + count, buffer);
+            visitor(static_cast<const double *>(buffer), count);
+        }
+    }
+
+    template <typename Visitor>
+    void forEachBlock(Visitor visitor) const
+    {
+        forEachBlock(0, _size, visitor);
+    }
+
+private:
+    static constexpr int blockSize = 4096;
+
+    Generator _generator = Uniform;
+    double _first = 0.0;
+    double _second = 1.0;
+    quint64 _seed = 0;
+    qint64 _size = 0;
+    double _offset = 0.0;
+};
+
+#endif // VIRTUALDATASET_H
@@ -1,4 +1,5 @@
 #include "calcunit.h"
+#include "tracing.h"
 #include <cmath>
 #include "QDebug"
 
@@ -7,6 +8,7 @@ CalcUnit::CalcUnit(const QVector<double> xValues,
     _xValues(xValues),
     _yValues(yValues)
 {
+    TRACE_SPAN("CalcUnit::CalcUnit");
     _linear_res = calculateLinearRegress();
     _squared_res = calculateQuadraticRegress();
     _cubic_res = calculateCubicRegress();
@@ -35,6 +37,7 @@ double CalcUnit::cubic_function(double x)
 
 DispersionResult CalcUnit::getDispersion()
 {
+    TRACE_SPAN("CalcUnit::getDispersion");
     DispersionResult result;
     for (int i = 0; i < _yValues.size(); i++)
     {
@@ -51,6 +54,7 @@ DispersionResult CalcUnit::getDispersion()
 
 LinearResult CalcUnit::calculateLinearRegress()
 {
+    TRACE_SPAN("CalcUnit::calculateLinearRegress");
     double size = _xValues.size();
     auto sum_x = std::accumulate(_xValues.cbegin(), _xValues.cend(), 0.0);
     auto sum_y = std::accumulate(_yValues.cbegin(), _yValues.cend(), 0.0);
@@ -70,6 +74,7 @@ LinearResult CalcUnit::calculateLinearRegress()
 
 QuadraticResult CalcUnit::calculateQuadraticRegress()
 {
+    TRACE_SPAN("CalcUnit::calculateQuadraticRegress");
     double size = _xValues.size();
     auto sum_x = std::accumulate(_xValues.cbegin(), _xValues.cend(), 0.0);
     auto sum_y = std::accumulate(_yValues.cbegin(), _yValues.cend(), 0.0);
@@ -103,6 +108,7 @@ QuadraticResult CalcUnit::calculateQuadraticRegress()
 
 CubicResult CalcUnit::calculateCubicRegress()
 {
+    TRACE_SPAN("CalcUnit::calculateCubicRegress");
     double size = _xValues.size();
     auto sum_x = std::accumulate(_xValues.cbegin(), _xValues.cend(), 0.0);
     auto sum_y = std::accumulate(_yValues.cbegin(), _yValues.cend(), 0.0);
@@ -147,6 +153,7 @@ CubicResult CalcUnit::calculateCubicRegress()
 
 QVector<double> CalcUnit::getPowVector(const QVector<double> &source, int squared)
 {
+    TRACE_SPAN("CalcUnit::getPowVector");
     QVector<double> result;
     result.reserve(source.size());
     for (const auto &value : qAsConst(source))
@@ -173,6 +180,7 @@ QVector<double> CalcUnit::multiplyVectorsValues(const QVector<double> &first,
 QVector<double> CalcUnit::calculatesystemOfLinearEquations(const QVector<QVector<double>> &matrix,
                                                  const QVector<double> &vector)
 {
+    TRACE_SPAN("CalcUnit::calculatesystemOfLinearEquations");
     QVector<double> result;
     auto det = determinant(matrix);
 
@@ -1,5 +1,39 @@
 #include "chartview.h"
+#include "downsampler.h"
 
+#include <QValueAxis>
+
+namespace
+{
+/// Число точек серии до прореживания, по нему выбирается режим анимации.
+const char *const sourcePointsProperty = "sourcePointCount";
+/// Настройки анимации графика, действовавшие до ее отключения.
+const char *const savedAnimationProperty = "savedAnimationOptions";
+
+/**
+ * Анимация выключена, пока хотя бы у одной серии графика больше
+ * ChartView::animationThreshold точек, после этого прежние настройки возвращаются.
+ */
+void updateAnimation(QChart *chart)
+{
+    bool large = false;
+    const auto seriesList = chart->series();
+    for (auto item : seriesList)
+        large = large || item->property(sourcePointsProperty).toInt() > ChartView::animationThreshold;
+
+    QVariant saved = chart->property(savedAnimationProperty);
+    if (large && !saved.isValid())
+    {
+        chart->setProperty(savedAnimationProperty, static_cast<int>(chart->animationOptions()));
+        chart->setAnimationOptions(QChart::NoAnimation);
+    }
+    else if (!large && saved.isValid())
+    {
+        chart->setAnimationOptions(QChart::AnimationOptions(saved.toInt()));
+        chart->setProperty(savedAnimationProperty, QVariant());
+    }
+}
+}
 
 ChartView::ChartView(QWidget *parent) : QChartView(parent)
 {
@@ -10,6 +44,22 @@ ChartView::ChartView(QChart *chart, QWidget *parent) : QChartView(chart, parent)
 {
 }
 
+void ChartView::addDownsampledSeries(QLineSeries *series, const QVector<QPointF> &points)
+{
+    downsampled.append(qMakePair(series, points));
+    updateDownsampledSeries();
+}
+
+void ChartView::setSeriesPoints(QXYSeries *series, const QVector<QPointF> &points, int sourceSize)
+{
+    series->setUseOpenGL(points.size() > openGLThreshold);
+    series->replace(points);
+
+    series->setProperty(sourcePointsProperty, sourceSize < 0 ? points.size() : sourceSize);
+    if (series->chart())
+        updateAnimation(series->chart());
+}
+
 void ChartView::wheelEvent(QWheelEvent *event)
 {
     if (event->angleDelta().y() != 0)
@@ -26,6 +76,7 @@ void ChartView::wheelEvent(QWheelEvent *event)
             chart()->zoomOut();
         }
 
+        updateDownsampledSeries();
         event->accept();
     }
 }
@@ -46,6 +97,7 @@ void ChartView::mouseMoveEvent(QMouseEvent *event)
         QPoint delta = event->pos() - lastMousePos;
         chart()->scroll(-delta.x(), delta.y());
         lastMousePos = event->pos();
+        updateDownsampledSeries();
     }
 }
 
@@ -56,3 +108,42 @@ void ChartView::mouseReleaseEvent(QMouseEvent *event)
         isDragging = false;
     }
 }
+
+void ChartView::resizeEvent(QResizeEvent *event)
+{
+    QChartView::resizeEvent(event);
+    updateDownsampledSeries();
+}
+
+void ChartView::updateDownsampledSeries()
+{
+    if (!chart())
+        return;
+
+    int threshold = qMax(16, static_cast<int>(chart()->plotArea().width()));
+
+    for (const auto &item : qAsConst(downsampled))
+    {
+        const auto &points = item.second;
+        if (points.isEmpty())
+            continue;
+
+        double from = points.first().x();
+        double to = points.last().x();
+        const auto axes = item.first->attachedAxes();
+        for (auto axis : axes)
+        {
+            auto valueAxis = qobject_cast<QValueAxis *>(axis);
+            if (valueAxis && valueAxis->orientation() == Qt::Horizontal)
+            {
+                from = valueAxis->min();
+                to = valueAxis->max();
+            }
+        }
+
+        auto range = Downsampler::visibleRange(points, from, to);
+        setSeriesPoints(item.first, Downsampler::lttb(points.constData() + range.first,
+                                                      range.second - range.first, threshold),
+                        points.size());
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef DOWNSAMPLER_H
+#define DOWNSAMPLER_H
+
+#include <QPointF>
+#include <QVector>
+
+/**
+ * @brief Прореживание точек графика перед выводом.
+ * @details Точки должны быть упорядочены по x. Алгоритм LTTB (largest triangle
+ * three buckets) сохраняет форму кривой.
+ */
+namespace Downsampler
+{
+QVector<QPointF> lttb(const QPointF *points, int size, int threshold);
+
+/// Видимый участок [from, to] с одной соседней точкой с каждой стороны.
+std::pair<int, int> visibleRange(const QVector<QPointF> &points, double from, double to);
+}
+
+#endif // DOWNSAMPLER_H
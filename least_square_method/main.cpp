@@ -1,11 +1,42 @@
 #include "widget.h"
+#include "tracing.h"
+#include "allocationpanel.h"
+#include "perfgate.h"
 
 #include <QApplication>
 
+namespace
+{
+QVector<PerfGate::Scenario> perfScenarios()
+{
+    return {{"least_squares", []()
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            CalcUnit unit;
+            unit.getDispersion();
+        }
+    }}};
+}
+}
+
 int main(int argc, char *argv[])
 {
+    // DATAANALYS_TRACE=<файл>: запись трассировки в формате Chrome trace при выходе
+    Tracing::enableFromEnvironment();
+    // DATAANALYS_ALLOC_STATS=1: учет памяти по этапам, панель по F12
+    AllocationStats::enableFromEnvironment();
+
+    // --perf-gate <база> / --perf-baseline <база>: проверка производительности без интерфейса
+    if (PerfGate::isRequested(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+        return PerfGate::run(argc, argv, perfScenarios());
+    }
+
     QApplication a(argc, argv);
     Widget w;
+    AllocationPanel::install(&w);
     w.show();
     return a.exec();
 }
@@ -1,4 +1,5 @@
 #include "widget.h"
+#include "tracing.h"
 
 #include <QChart>
 #include <QPainter>
@@ -19,6 +20,7 @@ using namespace QtCharts;
 Widget::Widget(QWidget *parent)
     : QWidget(parent)
 {
+    TRACE_SPAN("Widget::Widget");
     double min_x = 0.0;
     double max_x = 6.0;
 
@@ -36,16 +38,17 @@ Widget::Widget(QWidget *parent)
     auto cubic_series = new QLineSeries(this);
 
     QVector<SeriesInfo> info;
+    QVector<QPointF> linear_points, quadratic_points, cubic_points;
     for (double x = 1.0; x <= 5.0; x += 0.01)
     {
-        linear_series->append(x, _unit.linear_function(x));
-        quadratic_series->append(x, _unit.quadratic_function(x));
-        cubic_series->append(x, _unit.cubic_function(x));
+        linear_points.append(QPointF(x, _unit.linear_function(x)));
+        quadratic_points.append(QPointF(x, _unit.quadratic_function(x)));
+        cubic_points.append(QPointF(x, _unit.cubic_function(x)));
     }
 
-    SeriesInfo linear_info {Qt::blue, "Линейная аппроксимация", linear_series};
-    SeriesInfo quadratic_info {Qt::green, "Квадратичная аппроксимация", quadratic_series};
-    SeriesInfo cubic_info {Qt::darkYellow, "Кубическая аппроксимация", cubic_series};
+    SeriesInfo linear_info {Qt::blue, "Линейная аппроксимация", linear_series, linear_points};
+    SeriesInfo quadratic_info {Qt::green, "Квадратичная аппроксимация", quadratic_series, quadratic_points};
+    SeriesInfo cubic_info {Qt::darkYellow, "Кубическая аппроксимация", cubic_series, cubic_points};
     info << linear_info << quadratic_info << cubic_info;
 
     graph_layout->addWidget(createWidget(info, "Метод наименьших квадратов", min_x, max_x, min_y, max_y));
@@ -69,6 +72,7 @@ QChartView * Widget::createWidget(const QVector<SeriesInfo> series,
                                  double min_x, double max_x,
                                  double min_y, double max_y)
 {
+    TRACE_SPAN("Widget::createWidget");
     auto chart = new QChart;
     chart->setTitle(name);
 
@@ -108,6 +112,9 @@ QChartView * Widget::createWidget(const QVector<SeriesInfo> series,
     chart_view->setRubberBand(QChartView::RectangleRubberBand);
     chart_view->setInteractive(true);
 
+    for (const auto &ser : qAsConst(series))
+        chart_view->addDownsampledSeries(ser.series, ser.points);
+
     return chart_view;
 }
 
@@ -2,6 +2,7 @@
 #define WIDGET_H
 
 #include <QWidget>
+#include <QPointF>
 #include "calcunit.h"
 
 namespace QtCharts { class QChartView; class QLineSeries; class QChart; class QValueAxis;}
@@ -12,6 +13,7 @@ struct SeriesInfo
     Qt::GlobalColor color;
     QString name;
     QtCharts::QLineSeries * series;
+    QVector<QPointF> points;
 };
 
 class Widget : public QWidget {
@@ -0,0 +1,98 @@
+#include "binnedsample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+BinnedSample::BinnedSample(const QVector<double> &data) :
+    _sorted(data)
+{
+    if (data.isEmpty())
+        return;
+
+    _expectedValue = std::accumulate(data.begin(), data.end(), 0.0) / data.size();
+    for (const auto &value : data)
+        _dispersion += std::pow(value - _expectedValue, 2);
+    _dispersion = _dispersion / (data.size() - 1.0);
+
+    std::sort(_sorted.begin(), _sorted.end());
+}
+
+BinnedSample::BinnedSample(const QVector<qint32> &sortedRaw, qint32 scale) :
+    _sortedRaw(sortedRaw),
+    _scale(scale)
+{
+    if (sortedRaw.isEmpty())
+        return;
+
+    // Отклонения считаются в целых единицах, масштаб учитывается один раз.
+    qint64 sum = 0;
+    for (const auto &value : sortedRaw)
+        sum += value;
+    double meanRaw = sum / static_cast<double>(sortedRaw.size());
+    for (const auto &value : sortedRaw)
+        _dispersion += std::pow(value - meanRaw, 2);
+
+    _expectedValue = meanRaw / scale;
+    _dispersion = _dispersion / (static_cast<double>(scale) * scale) / (sortedRaw.size() - 1.0);
+}
+
+double BinnedSample::valueAt(int index) const
+{
+    return _scale > 0 ? _sortedRaw[index] / static_cast<double>(_scale) : _sorted[index];
+}
+
+int BinnedSample::countNotAbove(double bound) const
+{
+    if (_scale == 0)
+        return std::upper_bound(_sorted.begin(), _sorted.end(), bound) - _sorted.begin();
+
+    // Наибольшее целое, раскодированное значение которого не превышает bound:
+    // сравнение с ним совпадает со сравнением раскодированных значений.
+    qint64 threshold = static_cast<qint64>(std::floor(bound * _scale));
+    while ((threshold + 1) / static_cast<double>(_scale) <= bound)
+        threshold++;
+    while (threshold / static_cast<double>(_scale) > bound)
+        threshold--;
+
+    if (threshold < std::numeric_limits<qint32>::min())
+        return 0;
+    if (threshold >= std::numeric_limits<qint32>::max())
+        return _sortedRaw.size();
+    return std::upper_bound(_sortedRaw.begin(), _sortedRaw.end(), static_cast<qint32>(threshold)) - _sortedRaw.begin();
+}
+
+QVector<int> BinnedSample::histogram(int bins) const
+{
+    QVector<int> hist(bins, 0);
+    if (size() == 0 || bins <= 0)
+        return hist;
+
+    const double minValue = minimum();
+    const double delta = (maximum() - minValue) / bins;
+
+    int previousCount = 0;
+    for (int i = 0; i < bins; ++i)
+    {
+        double end_x = minValue + (i + 1) * delta;
+        int count = i == bins - 1 ? size() : countNotAbove(end_x);
+        hist[i] = count - previousCount;
+        previousCount = count;
+    }
+    return hist;
+}
+
+double BinnedSample::mode(int bins) const
+{
+    auto hist = histogram(bins);
+    if (hist.isEmpty())
+        return 0.0;
+
+    int maxIndex = std::max_element(hist.begin(), hist.end()) - hist.begin();
+    double delta = (maximum() - minimum()) / bins;
+    double start_x = minimum() + maxIndex * delta;
+    double end_x = minimum() + (maxIndex + 1) * delta;
+
+    return (start_x + end_x) / 2;
+}
@@ -0,0 +1,47 @@
+#ifndef BINNEDSAMPLE_H
+#define BINNEDSAMPLE_H
+
+#include <QVector>
+
+/**
+ * @brief Отсортированная выборка для быстрой смены числа интервалов.
+ * @details Выборка сортируется один раз, после чего гистограмма на любое число
+ * интервалов строится двоичным поиском границ за O(число интервалов · log n)
+ * без повторного просмотра данных. Правило то же, что у CalcUnit::createHistogramSet:
+ * значение на границе относится к левому интервалу, значения выше округленной
+ * последней границы - к последнему.
+ * Выборка с фиксированной точкой хранится в целых без перевода в double.
+ */
+class BinnedSample
+{
+public:
+    explicit BinnedSample(const QVector<double> &data);
+
+    /// Упорядоченная выборка с фиксированной точкой: значения sortedRaw[i] / scale.
+    BinnedSample(const QVector<qint32> &sortedRaw, qint32 scale);
+
+    int size() const { return _scale > 0 ? _sortedRaw.size() : _sorted.size(); }
+    double minimum() const { return size() == 0 ? 0.0 : valueAt(0); }
+    double maximum() const { return size() == 0 ? 0.0 : valueAt(size() - 1); }
+
+    double expectedValue() const { return _expectedValue; }
+    double dispersion() const { return _dispersion; }
+
+    /// Гистограмма между крайними значениями выборки.
+    QVector<int> histogram(int bins) const;
+    double mode(int bins) const;
+
+private:
+    double valueAt(int index) const;
+    /// Число значений, не превышающих bound.
+    int countNotAbove(double bound) const;
+
+private:
+    QVector<double> _sorted;
+    QVector<qint32> _sortedRaw;
+    qint32 _scale = 0;      ///< Масштаб целых значений, 0 - выборка в double
+    double _expectedValue = 0.0;
+    double _dispersion = 0.0;
+};
+
+#endif // BINNEDSAMPLE_H
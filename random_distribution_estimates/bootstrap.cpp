@@ -0,0 +1,240 @@
+#include "bootstrap.h"
+
+#include <boost/math/distributions/normal.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr int blockSize = 256;
+constexpr int statisticsCount = 5;
+
+enum StatisticIndex { Mean = 0, Median, Dispersion, Skewness, Kurtosis };
+
+/// Характеристики выборки, заданной кратностями элементов отсортированного массива.
+void weightedStatistics(const std::vector<double> &sorted, const std::vector<int> &counts,
+                        int size, double *result)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < sorted.size(); i++)
+        sum += counts[i] * sorted[i];
+    double mean = sum / size;
+
+    double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+    int lowRank = size / 2 - 1;
+    int highRank = size / 2;
+    double low = sorted.front(), high = sorted.front();
+    int seen = 0;
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        double diff = sorted[i] - mean;
+        double diff2 = diff * diff;
+        m2 += counts[i] * diff2;
+        m3 += counts[i] * diff2 * diff;
+        m4 += counts[i] * diff2 * diff2;
+
+        if (seen <= lowRank && seen + counts[i] > lowRank)
+            low = sorted[i];
+        if (seen <= highRank && seen + counts[i] > highRank)
+            high = sorted[i];
+        seen += counts[i];
+    }
+
+    result[Mean] = mean;
+    result[Median] = (low + high) / 2.0;
+    result[Dispersion] = m2 / (size - 1.0);
+    result[Skewness] = m3 / size;
+    result[Kurtosis] = m4 / size;
+}
+
+/// Характеристики выборок без одного элемента (складной нож), O(n) для всей выборки.
+std::vector<std::vector<double>> jackknifeStatistics(const std::vector<double> &sorted)
+{
+    const int n = static_cast<int>(sorted.size());
+    const int m = n - 1;
+
+    double center = 0.0;
+    for (const auto &value : sorted)
+        center += value;
+    center /= n;
+
+    double s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0;
+    for (const auto &value : sorted)
+    {
+        double y = value - center;
+        s1 += y;
+        s2 += y * y;
+        s3 += y * y * y;
+        s4 += y * y * y * y;
+    }
+
+    // Элемент с индексом j в выборке без i-го элемента
+    auto without = [&sorted](int i, int j) { return j < i ? sorted[j] : sorted[j + 1]; };
+
+    std::vector<std::vector<double>> result(statisticsCount, std::vector<double>(n));
+    for (int i = 0; i < n; i++)
+    {
+        double y = sorted[i] - center;
+        double t1 = s1 - y;
+        double t2 = s2 - y * y;
+        double t3 = s3 - y * y * y;
+        double t4 = s4 - y * y * y * y;
+
+        double shift = t1 / m;
+        double shift2 = shift * shift;
+        double c2 = t2 - m * shift2;
+        double c3 = t3 - 3 * shift * t2 + 2 * m * shift2 * shift;
+        double c4 = t4 - 4 * shift * t3 + 6 * shift2 * t2 - 3 * m * shift2 * shift2;
+
+        result[Mean][i] = center + shift;
+        result[Median][i] = (without(i, m / 2 - 1) + without(i, m / 2)) / 2.0;
+        result[Dispersion][i] = c2 / (m - 1.0);
+        result[Skewness][i] = c3 / m;
+        result[Kurtosis][i] = c4 / m;
+    }
+    return result;
+}
+
+double percentile(const std::vector<double> &sorted, double probability)
+{
+    double position = probability * (sorted.size() - 1);
+    size_t index = static_cast<size_t>(position);
+    if (index + 1 >= sorted.size())
+        return sorted.back();
+    double fraction = position - index;
+    return sorted[index] + fraction * (sorted[index + 1] - sorted[index]);
+}
+
+BootstrapInterval makeInterval(std::vector<double> &replicates,
+                               const std::vector<double> &jackknife,
+                               double estimate, double probability)
+{
+    BootstrapInterval result;
+    result.estimate = estimate;
+
+    std::sort(replicates.begin(), replicates.end());
+    result.percentile = std::make_pair(percentile(replicates, probability),
+                                       percentile(replicates, 1 - probability));
+
+    // Поправка на смещение: доля повторных оценок ниже исходной
+    auto lower = std::lower_bound(replicates.begin(), replicates.end(), estimate) - replicates.begin();
+    auto upper = std::upper_bound(replicates.begin(), replicates.end(), estimate) - replicates.begin();
+    double below = (lower + upper) / 2.0 / replicates.size();
+
+    // Ускорение по оценкам складного ножа
+    double jackMean = 0.0;
+    for (const auto &value : jackknife)
+        jackMean += value;
+    jackMean /= jackknife.size();
+
+    double numerator = 0.0, denominator = 0.0;
+    for (const auto &value : jackknife)
+    {
+        double diff = jackMean - value;
+        numerator += diff * diff * diff;
+        denominator += diff * diff;
+    }
+
+    if (below <= 0.0 || below >= 1.0 || denominator <= 0.0)
+    {
+        result.bca = result.percentile;
+        return result;
+    }
+
+    boost::math::normal_distribution<> normal;
+    double z0 = boost::math::quantile(normal, below);
+    double acceleration = numerator / (6.0 * std::pow(denominator, 1.5));
+
+    auto adjusted = [&](double level)
+    {
+        double z = z0 + boost::math::quantile(normal, level);
+        return boost::math::cdf(normal, z0 + z / (1.0 - acceleration * z));
+    };
+
+    result.bca = std::make_pair(percentile(replicates, adjusted(probability)),
+                                percentile(replicates, adjusted(1 - probability)));
+    return result;
+}
+}
+
+BootstrapEngine::BootstrapEngine(double probability, int resamples, quint64 seed, int threads) :
+    _probability(probability),
+    _resamples(resamples),
+    _seed(seed),
+    _threads(threads)
+{
+}
+
+BootstrapResult BootstrapEngine::compute(const QVector<double> &data) const
+{
+    BootstrapResult result;
+    if (data.size() < 3 || _resamples <= 0)
+        return result;
+
+    std::vector<double> sorted(data.begin(), data.end());
+    std::sort(sorted.begin(), sorted.end());
+    const int size = static_cast<int>(sorted.size());
+
+    double estimate[statisticsCount];
+    weightedStatistics(sorted, std::vector<int>(size, 1), size, estimate);
+
+    std::vector<std::vector<double>> replicates(statisticsCount, std::vector<double>(_resamples));
+
+    const int blocks = (_resamples + blockSize - 1) / blockSize;
+    std::atomic<int> nextBlock(0);
+
+    auto worker = [&]()
+    {
+        std::vector<int> counts(size);
+        double statistics[statisticsCount];
+
+        for (int block = nextBlock++; block < blocks; block = nextBlock++)
+        {
+            std::seed_seq seq{static_cast<quint32>(_seed), static_cast<quint32>(_seed >> 32),
+                              static_cast<quint32>(block)};
+            std::mt19937_64 gen(seq);
+            std::uniform_int_distribution<int> dis(0, size - 1);
+
+            int end = std::min(_resamples, (block + 1) * blockSize);
+            for (int r = block * blockSize; r < end; r++)
+            {
+                std::fill(counts.begin(), counts.end(), 0);
+                for (int i = 0; i < size; i++)
+                    counts[dis(gen)]++;
+
+                weightedStatistics(sorted, counts, size, statistics);
+                for (int s = 0; s < statisticsCount; s++)
+                    replicates[s][r] = statistics[s];
+            }
+        }
+    };
+
+    int threads = _threads > 0 ? _threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, blocks));
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; i++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+        thread.join();
+
+    auto jackknife = jackknifeStatistics(sorted);
+
+    result.expectedValue = makeInterval(replicates[Mean], jackknife[Mean], estimate[Mean], _probability);
+    result.median = makeInterval(replicates[Median], jackknife[Median], estimate[Median], _probability);
+    result.dispersion = makeInterval(replicates[Dispersion], jackknife[Dispersion], estimate[Dispersion], _probability);
+    result.skewness = makeInterval(replicates[Skewness], jackknife[Skewness], estimate[Skewness], _probability);
+    result.kurtosis = makeInterval(replicates[Kurtosis], jackknife[Kurtosis], estimate[Kurtosis], _probability);
+    result.resamples = _resamples;
+
+    return result;
+}
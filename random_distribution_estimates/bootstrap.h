@@ -0,0 +1,53 @@
+#ifndef BOOTSTRAP_H
+#define BOOTSTRAP_H
+
+#include <QVector>
+
+struct BootstrapInterval
+{
+    double estimate = 0.0;                      ///< Оценка по исходной выборке
+    std::pair<double, double> percentile;       ///< Процентильный интервал
+    std::pair<double, double> bca;              ///< Интервал BCa (с поправкой на смещение и ускорение)
+};
+
+struct BootstrapResult
+{
+    BootstrapInterval expectedValue;            ///< Математическое ожидание
+    BootstrapInterval median;                   ///< Медиана
+    BootstrapInterval dispersion;               ///< Дисперсия
+    BootstrapInterval skewness;                 ///< Коэффициент ассиметрии
+    BootstrapInterval kurtosis;                 ///< Эксцесс
+
+    int resamples = 0;                          ///< Количество повторных выборок
+};
+
+/**
+ * @brief Бутстреп-оценка доверительных интервалов выборочных характеристик.
+ * @details Повторные выборки не копируются: для каждой из них считается только
+ * кратность попадания элементов отсортированной исходной выборки, по которой
+ * за один проход находятся все характеристики. Повторные выборки разбиты на
+ * блоки, каждый блок имеет собственный поток случайных чисел, поэтому результат
+ * не зависит от числа рабочих потоков.
+ */
+class BootstrapEngine
+{
+public:
+    /**
+     * @param probability Уровень значимости с каждой стороны интервала.
+     * @param resamples Количество повторных выборок.
+     * @param seed Начальное значение генераторов.
+     * @param threads Количество рабочих потоков, 0 - по числу ядер.
+     */
+    BootstrapEngine(double probability, int resamples = 10000,
+                    quint64 seed = 0, int threads = 0);
+
+    BootstrapResult compute(const QVector<double> &data) const;
+
+private:
+    double _probability;
+    int _resamples;
+    quint64 _seed;
+    int _threads;
+};
+
+#endif // BOOTSTRAP_H
@@ -1,11 +1,16 @@
 #include "calcunit.h"
 
 #include "calcunit.h"
-#include <boost/math/distributions/students_t.hpp>
-#include <boost/math/distributions/chi_squared.hpp>
+#include "kerneldensity.h"
+#include "normalkernel.h"
+#include "quantilecache.h"
+#include "samplefile.h"
+#include "samplekernels.h"
+#include "tracing.h"
 
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <QHash>
 #include <QtMath>
 #include <QFile>
@@ -26,44 +31,28 @@ CalcUnit::CalcUnit(int variantNumber, double a) :
     _variantNumber(variantNumber),
     _a(a)
 {
+    TRACE_SPAN("CalcUnit::CalcUnit");
     //You need to create file with values
     QString dataFile = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/random_data.txt";
     if(!readDataFromFile(dataFile))
         Q_ASSERT(false);
 }
 
-bool CalcUnit::readDataFromFile(const QString& filePath)
+CalcUnit::CalcUnit(const QVector<double> &data, int variantNumber, double a) :
+    _randomValues(data),
+    _variantNumber(variantNumber),
+    _a(a)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        qDebug() << "Failed to open file for reading:" << filePath;
-        return false;
-    }
-
-    QTextStream in(&file);
-    QVector<double> data;
-
-    while (!in.atEnd())
-    {
-        auto line = in.readLine();
-        bool ok;
-        double value = line.toDouble(&ok);
-        if (ok)
-            data.append(value);
-        else
-        {
-            qDebug() << "Failed to convert line to double:" << line;
-            return false;
-        }
-    }
+}
 
-    _randomValues = data;
-    file.close();
-    return true;
+bool CalcUnit::readDataFromFile(const QString& filePath)
+{
+    TRACE_SPAN("CalcUnit::readDataFromFile");
+    return SampleFile::read(filePath, _randomValues);
 }
 
-double CalcUnit::calculateMode(const QVector<double> &data, int ranges)
+template<typename T>
+double CalcUnit::calculateMode(const QVector<T> &data, int ranges) const
 {
     auto hist = createHistogramSet(data, ranges);
     int maxIndex = 0;
@@ -83,30 +72,20 @@ double CalcUnit::calculateMode(const QVector<double> &data, int ranges)
     return (start_x + end_x) / 2;
 }
 
-Statistics CalcUnit::calculateStatistics(const QVector<double> &data, int size)
+template<typename T>
+Statistics CalcUnit::sampleStatistics(const QVector<T> &data, int size, double densityMode) const
 {
-    QVector<double> sortedData = data;
+    QVector<T> sortedData = data;
     std::sort(sortedData.begin(), sortedData.end());
 
-    double expectedValue = std::accumulate(data.begin(), data.end(), 0.0) / data.size();
+    auto moments = SampleKernels::moments<4>(data.constData(), data.size());
+    double expectedValue = moments.mean;
     double mode = calculateMode(data, size);
-    double median = (sortedData[sortedData.size() / 2 - 1] + sortedData[sortedData.size() / 2]) / 2.0;
-
-    double dispersion = 0.0;
-    double skewness = 0.0;
-    double kurtosis = 0.0;
-
-    for (const auto &value : qAsConst(data))
-    {
-        double diff = value - expectedValue;
-        dispersion += std::pow(diff, 2);
-        skewness += std::pow(diff, 3);
-        kurtosis += std::pow(diff, 4);
-    }
+    double median = (static_cast<double>(sortedData[sortedData.size() / 2 - 1]) + sortedData[sortedData.size() / 2]) / 2.0;
 
-    dispersion = dispersion / (data.size() - 1.0);
-    skewness = skewness / data.size();
-    kurtosis = kurtosis / data.size();
+    double dispersion = moments.m2 / (data.size() - 1.0);
+    double skewness = moments.m3 / data.size();
+    double kurtosis = moments.m4 / data.size();
 
     double std_dev = std::sqrt(dispersion);
     double standardError = std_dev / std::sqrt(data.size());
@@ -115,114 +94,315 @@ Statistics CalcUnit::calculateStatistics(const QVector<double> &data, int size)
 
     return {expectedValue, dispersion, median, mode, std_dev,
             skewness, kurtosis, standardError,
-            std::make_pair(expectedValue - tValue, expectedValue + tValue)};
+            std::make_pair(expectedValue - tValue, expectedValue + tValue),
+            densityMode};
 }
 
-double CalcUnit::calculateCriticalX(double probability, int degrees_of_freedom)
+Statistics CalcUnit::calculateStatistics(const QVector<double> &data, int size) const
 {
-        boost::math::chi_squared mydist(degrees_of_freedom);
-        return quantile(mydist, 1 - probability);
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return sampleStatistics(data, size, KernelDensity(data).mode());
 }
 
-double CalcUnit::inverseStudent(double probability, int degrees_of_freedom)
+Statistics CalcUnit::calculateStatistics(const QVector<double> &data, int size, const KernelDensity &density) const
 {
-    boost::math::students_t dist(degrees_of_freedom);
-    return quantile(dist, 1 - probability);
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return sampleStatistics(data, size, density.mode());
 }
 
-QVector<int> CalcUnit::createHistogramSet(const QVector<double>& data, int ranges)
+Statistics CalcUnit::calculateStatistics(const QVector<float> &data, int size) const
 {
-    auto min_max = std::minmax_element(data.begin(), data.end());
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    return sampleStatistics(data, size, KernelDensity(data).mode());
+}
 
-    double range = *min_max.second - *min_max.first;
-    double delta = range / ranges;
+double CalcUnit::calculateCriticalX(double probability, int degrees_of_freedom) const
+{
+    return QuantileCache::chiSquared(probability, degrees_of_freedom);
+}
 
-    QVector<int> hist(ranges, 0);
-    for (const auto &value : data)
-    {
-        for (int i = 0; i < ranges; ++i)
-        {
-            double start_x = *min_max.first + i * delta;
-            double end_x = *min_max.first + (i + 1) * delta;
-
-            if (value >= start_x && value <= end_x)
-            {
-                hist[i]++;
-                break;
-            }
-        }
-    }
-    return hist;
+double CalcUnit::inverseStudent(double probability, int degrees_of_freedom) const
+{
+    return QuantileCache::student(probability, degrees_of_freedom);
+}
+
+QVector<int> CalcUnit::createHistogramSet(const QVector<double>& data, int ranges) const
+{
+    TRACE_SPAN("CalcUnit::createHistogramSet");
+    return SampleKernels::histogram(data.constData(), data.size(), ranges);
+}
+
+QVector<int> CalcUnit::createHistogramSet(const QVector<float>& data, int ranges) const
+{
+    TRACE_SPAN("CalcUnit::createHistogramSet");
+    return SampleKernels::histogram(data.constData(), data.size(), ranges);
+}
+
+HistInfo CalcUnit::getHistogramAnalysis(const QVector<double>& data, int ranges) const
+{
+    return getHistogramAnalysis(data, QVector<int>() << ranges).first();
+}
+
+QVector<HistInfo> CalcUnit::getHistogramAnalysis(const QVector<double> &data, const QVector<int> &rangesList) const
+{
+    TRACE_SPAN("CalcUnit::getHistogramAnalysis");
+    BinnedSample sample(data);
+
+    QVector<HistInfo> result;
+    result.reserve(rangesList.size());
+    for (const auto &ranges : rangesList)
+        result.append(getHistogramAnalysis(sample, ranges));
+    return result;
+}
+
+QVector<HistInfo> CalcUnit::getHistogramAnalysis(const QVector<float> &data, const QVector<int> &rangesList) const
+{
+    TRACE_SPAN("CalcUnit::getHistogramAnalysis");
+    if (data.size() < 2)
+        return {};
+
+    // Гистограммы строятся прямо по float, границы и моменты - в double.
+    const auto minMax = std::minmax_element(data.cbegin(), data.cend());
+    const auto moments = SampleKernels::moments<2>(data.constData(), data.size());
+    const double dispersion = moments.m2 / (data.size() - 1.0);
+
+    QVector<HistInfo> result;
+    result.reserve(rangesList.size());
+    for (const auto &ranges : rangesList)
+        result.append(analyzeHistogram(*minMax.first, *minMax.second, createHistogramSet(data, ranges),
+                                       moments.mean, dispersion));
+    return result;
+}
+
+HistInfo CalcUnit::getHistogramAnalysis(const BinnedSample &sample, int ranges) const
+{
+    TRACE_SPAN("CalcUnit::getHistogramAnalysis");
+    return analyzeHistogram(sample.minimum(), sample.maximum(), sample.histogram(ranges),
+                            sample.expectedValue(), sample.dispersion());
 }
 
-HistInfo CalcUnit::getHistogramAnalysis(const QVector<double>& data, int ranges)
+HistInfo CalcUnit::analyzeHistogram(double minValue, double maxValue, const QVector<int> &values,
+                                    double expectedValue, double dispersion) const
 {
+    const int ranges = values.size();
+    const qint64 size = std::accumulate(values.begin(), values.end(), qint64(0));
+
     HistInfo result;
     result.ranges.resize(ranges);
-    result.values.resize(ranges);
+    result.values = values;
     result.probabilitiesRanges.resize(ranges);
     result.probabilities.resize(ranges);
     result.muliplyProbabilities.resize(ranges);
     result.squaredMuliplyProbabilities.resize(ranges);
     result.results.resize(ranges);
 
-    auto min_max = std::minmax_element(data.begin(), data.end());
+    const double delta = (maxValue - minValue) / ranges;
+    QVector<double> edges(ranges + 1);
+    for (int i = 0; i < ranges; ++i)
+    {
+        double start_x = minValue + i * delta;
+        double end_x = minValue + (i + 1) * delta;
+        result.ranges[i] = std::make_pair(start_x, end_x);
+        edges[i] = start_x;
+    }
+    edges[ranges] = result.ranges.last().second;
 
-    double range = *min_max.second - *min_max.first;
-    double delta = range / ranges;
+    auto edgeProbabilities = normalDistributionFunction(edges, expectedValue, dispersion);
+    edgeProbabilities.first() = 0;
+    edgeProbabilities.last() = 1;
 
-    double dispersion = 0.0;
-    double expectedValue = std::accumulate(data.begin(), data.end(), 0.0) / data.size();
+    for (int i = 0; i < ranges; i++)
+    {
+        result.probabilitiesRanges[i] = std::make_pair(edgeProbabilities[i], edgeProbabilities[i + 1]);
+        result.probabilities[i] = edgeProbabilities[i + 1] - edgeProbabilities[i];
+    }
 
-    for (const auto &value : data)
+    SampleKernels::chiSquaredTerms(result.values.constData(), edgeProbabilities.constData(), size, ranges,
+                                   result.muliplyProbabilities.data(), result.squaredMuliplyProbabilities.data(),
+                                   result.results.data(), normilize);
+    result.x_crit = calculateCriticalX(_a, ranges - 2 - 1);
+    return result;
+}
+
+namespace
+{
+/// Предел значений окна медианы, передаваемых из одного прохода
+constexpr qint64 maxWindow = 1 << 20;
+
+/// Интервал эскиза, содержащий значение заданного ранга
+struct RankBin
+{
+    AccumulatorLayout layout;   ///< Разметка с окном из этого интервала
+    qint64 below = 0;           ///< Число значений в предыдущих интервалах
+    bool tied = false;          ///< Переполнен и не разбивается: значения совпадают до шага double
+};
+
+/// Поиск интервала эскиза с рангом rank. Переполненный интервал вместе с соседними
+/// разбивается новым эскизом, чтобы совпадающие значения или далекие выбросы
+/// не превращали окно в большую часть выборки.
+RankBin locateRank(const CalcUnit::AccumulatorPass &pass, AccumulatorLayout layout,
+                   QVector<qint64> sketch, qint64 rank)
+{
+    // Разбиение сужает диапазон в sketchBins / 3 раз, восьми хватает до шага double.
+    constexpr int maxRefinements = 8;
+    layout.bins = 0;
+    for (int refinement = 0; ; refinement++)
     {
-        dispersion += std::pow(value - expectedValue, 2);
-        for (int i = 0; i < ranges; ++i)
+        int bin = 0;
+        qint64 below = 0;
+        while (bin < sketch.size() - 1 && below + sketch[bin] <= rank)
+            below += sketch[bin++];
+
+        const double step = (layout.upper - layout.lower) / layout.sketchBins;
+        const double lower = layout.lower + std::max(bin - 1, 0) * step;
+        const double upper = layout.lower + std::min(bin + 2, layout.sketchBins) * step;
+        if (sketch[bin] <= maxWindow || refinement == maxRefinements || !(lower < upper))
         {
-            double start_x = *min_max.first + i * delta;
-            double end_x = *min_max.first + (i + 1) * delta;
-            result.ranges[i] = std::make_pair(start_x, end_x);
-
-            if (value >= start_x && value <= end_x)
-            {
-                result.values[i]++;
-                break;
-            }
+            layout.windowFirst = bin;
+            layout.windowLast = bin;
+            return {layout, below, sketch[bin] > maxWindow};
         }
+
+        // Значения за краями нового диапазона попадают в крайние интервалы,
+        // поэтому накопленные частоты остаются рангами всей выборки.
+        layout.lower = lower;
+        layout.upper = upper;
+        sketch = pass(layout).sketch();
     }
-    dispersion = dispersion / (data.size() - 1.0);
-    for (int i = 0; i < ranges; i++)
+}
+
+/// Значение ранга rank из окна интервала, NaN при неполном окне
+double rankValue(const CalcUnit::AccumulatorPass &pass, const RankBin &bin, qint64 rank)
+{
+    if (bin.tied)
     {
-        const double &start_x = result.ranges[i].first;
-        const double &end_x = result.ranges[i].second;
+        const double step = (bin.layout.upper - bin.layout.lower) / bin.layout.sketchBins;
+        return bin.layout.lower + (bin.layout.windowFirst + 0.5) * step;
+    }
+    auto window = pass(bin.layout).window();
+    const qint64 index = rank - bin.below;
+    if (window.size() <= index)
+        return std::numeric_limits<double>::quiet_NaN();
+    std::nth_element(window.begin(), window.begin() + index, window.end());
+    return window[index];
+}
+}
+
+Statistics CalcUnit::calculateStatistics(const AccumulatorPass &pass, int ranges) const
+{
+    TRACE_SPAN("CalcUnit::calculateStatistics");
+    // Эскиза из 2^14 интервалов хватает, чтобы окно медианы было малой долей выборки,
+    // и он остается небольшим при передаче между процессами.
+    constexpr int sketchBins = 1 << 14;
+
+    // Первый проход: моменты и крайние значения.
+    const auto moments = pass(AccumulatorLayout());
+    const qint64 count = moments.count();
+    if (count < 2)
+        return {};
+
+    // Второй проход: гистограмма для моды и эскиз рангов для медианы.
+    AccumulatorLayout layout;
+    layout.lower = moments.minimum();
+    layout.upper = moments.maximum();
+    layout.bins = ranges;
+    layout.sketchBins = sketchBins;
+    const auto distribution = pass(layout);
+
+    const auto &hist = distribution.histogram();
+    int maxIndex = 0;
+    for (int i = 0; i < hist.size(); i++)
+    {
+        if (hist[i] > hist[maxIndex])
+            maxIndex = i;
+    }
+    double delta = (layout.upper - layout.lower) / ranges;
+    double start_x = layout.lower + maxIndex * delta;
+    double end_x = layout.lower + (maxIndex + 1) * delta;
+    double mode = (start_x + end_x) / 2;
+
+    // Третий проход: значения из интервалов эскиза, содержащих средние ранги.
+    const auto &sketch = distribution.sketch();
+    const qint64 lowRank = count / 2 - 1;
+    const qint64 highRank = count / 2;
+    const auto low = locateRank(pass, layout, sketch, lowRank);
+    const auto high = locateRank(pass, layout, sketch, highRank);
+
+    double median;
+    if (!low.tied && !high.tied && low.layout.lower == high.layout.lower
+        && low.layout.upper == high.layout.upper)
+    {
+        auto window = low.layout;
+        window.windowLast = high.layout.windowLast;
+        auto middle = pass(window).window();
+        std::sort(middle.begin(), middle.end());
+
+        // Окно неполно, только если участки изменились между проходами.
+        median = middle.size() > highRank - low.below
+                 ? (middle[lowRank - low.below] + middle[highRank - low.below]) / 2.0
+                 : std::numeric_limits<double>::quiet_NaN();
+    }
+    else
+        median = (rankValue(pass, low, lowRank) + rankValue(pass, high, highRank)) / 2.0;
+
+    double dispersion = moments.dispersion();
+    double std_dev = std::sqrt(dispersion);
+    double standardError = std_dev / std::sqrt(static_cast<double>(count));
+
+    int degreesOfFreedom = static_cast<int>(std::min<qint64>(count - 1, std::numeric_limits<int>::max()));
+    auto tValue = inverseStudent(_a, degreesOfFreedom) * standardError;
+
+    // Оценка плотности строится по эскизу второго прохода без отдельного прохода.
+    KernelDensity density(sketch, layout.lower, layout.upper);
 
-        double start_x_prob =  i == 0 ? 0 : normalDistributionFunction(start_x, expectedValue, dispersion);
-        double end_x_prob = i == ranges - 1 ? 1 : normalDistributionFunction(end_x, expectedValue, dispersion);
-        double range = end_x_prob - start_x_prob;
+    return {moments.mean(), dispersion, median, mode, std_dev,
+            moments.centralMoment(3), moments.centralMoment(4), standardError,
+            std::make_pair(moments.mean() - tValue, moments.mean() + tValue),
+            density.mode()};
+}
+
+QVector<HistInfo> CalcUnit::getHistogramAnalysis(const AccumulatorPass &pass, const QVector<int> &rangesList) const
+{
+    TRACE_SPAN("CalcUnit::getHistogramAnalysis");
+    const auto moments = pass(AccumulatorLayout());
 
-        result.probabilitiesRanges[i] = std::make_pair(start_x_prob, end_x_prob);
-        result.probabilities[i] = range;
+    QVector<HistInfo> result;
+    if (moments.count() == 0)
+        return result;
 
-        double muliplyProb = normilize(range * data.size(), 4);
-        result.muliplyProbabilities[i] = muliplyProb;
+    for (const auto &ranges : rangesList)
+    {
+        AccumulatorLayout layout;
+        layout.lower = moments.minimum();
+        layout.upper = moments.maximum();
+        layout.bins = ranges;
+        const auto distribution = pass(layout);
 
-        double squaredMuliplyProb = normilize(pow(result.values[i] - muliplyProb, 2), 5);
-        result.squaredMuliplyProbabilities[i] = squaredMuliplyProb;
+        QVector<int> values;
+        for (auto value : distribution.histogram())
+            values.append(static_cast<int>(value));
 
-        result.results[i] = normilize(squaredMuliplyProb / muliplyProb, 4);
+        result.append(analyzeHistogram(layout.lower, layout.upper, values, moments.mean(), moments.dispersion()));
     }
-    result.x_crit = calculateCriticalX(_a, ranges - 2 - 1);
     return result;
 }
 
-QVector<double> CalcUnit::randomData()
+BootstrapResult CalcUnit::bootstrapIntervals(const QVector<double> &data, int resamples) const
+{
+    TRACE_SPAN("CalcUnit::bootstrapIntervals");
+    return BootstrapEngine(_a, resamples).compute(data);
+}
+
+QVector<double> CalcUnit::randomData() const
 {
     return _randomValues;
 }
 
-double CalcUnit::normalDistributionFunction(double x, double mean, double dispersion)
+QVector<double> CalcUnit::normalDistributionFunction(const QVector<double> &x, double mean, double dispersion) const
 {
-    boost::math::normal_distribution<> normalDist(mean, std::sqrt(dispersion));
-    return normilize(boost::math::cdf(normalDist, x), 4);
+    auto result = NormalKernel::cdf(x, mean, std::sqrt(dispersion));
+    for (auto &value : result)
+        value = normilize(value, 4);
+    return result;
 }
 
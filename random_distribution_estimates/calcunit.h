@@ -3,6 +3,11 @@
 
 #include <QVector>
 #include <QHash>
+#include "bootstrap.h"
+#include "binnedsample.h"
+#include "statisticsaccumulator.h"
+
+class KernelDensity;
 
 struct Statistics
 {
@@ -16,6 +21,7 @@ struct Statistics
     double standartError;       ///< Стандартная ошибка
 
     std::pair<double, double> confidenceInterval; ///< Доверительный интервал
+    double densityMode;         ///< Мода по ядерной оценке плотности
 };
 
 struct HistInfo
@@ -37,19 +43,53 @@ class CalcUnit
 {
 public:
     CalcUnit(int variantNumber = 10, double a = 0.025);
+    /// Расчетник по готовой выборке, без чтения файла варианта.
+    explicit CalcUnit(const QVector<double> &data, int variantNumber = 10, double a = 0.025);
+
+    Statistics calculateStatistics(const QVector<double>& data, int ranges) const;
+    QVector<int> createHistogramSet(const QVector<double>& data, int ranges) const;
+
+    /// Мода плотности берется из уже построенной по data оценки.
+    Statistics calculateStatistics(const QVector<double>& data, int ranges, const KernelDensity &density) const;
+
+    /// Выборка во float вдвое меньше в памяти, расчет тот же, накопление в double.
+    Statistics calculateStatistics(const QVector<float>& data, int ranges) const;
+    QVector<int> createHistogramSet(const QVector<float>& data, int ranges) const;
+    QVector<HistInfo> getHistogramAnalysis(const QVector<float> &data, const QVector<int> &rangesList) const;
+    HistInfo getHistogramAnalysis(const QVector<double> &data, int ranges) const;
+    QVector<HistInfo> getHistogramAnalysis(const QVector<double> &data, const QVector<int> &rangesList) const;
+    HistInfo getHistogramAnalysis(const BinnedSample &sample, int ranges) const;
+    BootstrapResult bootstrapIntervals(const QVector<double> &data, int resamples = 10000) const;
+
+    /// Проход по всем участкам выборки с объединением их накопителей.
+    using AccumulatorPass = std::function<StatisticsAccumulator(const AccumulatorLayout &)>;
 
-    Statistics calculateStatistics(const QVector<double>& data, int ranges);
-    QVector<int> createHistogramSet(const QVector<double>& data, int ranges);
-    HistInfo getHistogramAnalysis(const QVector<double> &data, int ranges);
+    /**
+     * Расчет по участкам выборки (файлам, процессам) без сбора ее в памяти:
+     * моменты и крайние значения, гистограмма с квантильным эскизом и окно
+     * значений для точной медианы. Переполненные интервалы эскиза у медианы
+     * (совпадающие значения, выбросы) разбиваются дополнительными проходами,
+     * в интервале окна не больше 2^20 значений. Медиана и мода совпадают с расчетом по всей
+     * выборке, остальные характеристики - с точностью до округления. Оценка
+     * плотности строится по эскизу, ее мода отличается от расчета в памяти
+     * в пределах шага эскиза.
+     */
+    Statistics calculateStatistics(const AccumulatorPass &pass, int ranges) const;
+    QVector<HistInfo> getHistogramAnalysis(const AccumulatorPass &pass, const QVector<int> &rangesList) const;
 
-    QVector<double> randomData();
+    QVector<double> randomData() const;
 
 private:
-    double calculateMode(const QVector<double>& data, int ranges);
+    template<typename T>
+    double calculateMode(const QVector<T>& data, int ranges) const;
+    template<typename T>
+    Statistics sampleStatistics(const QVector<T>& data, int ranges, double densityMode) const;
     bool readDataFromFile(const QString &fileName);
-    double inverseStudent(double alpha, int degreesOfFreedom);
-    double normalDistributionFunction(double x, double mean, double std_dev);
-    double calculateCriticalX(double probability, int degrees_of_freedom);
+    double inverseStudent(double alpha, int degreesOfFreedom) const;
+    QVector<double> normalDistributionFunction(const QVector<double> &x, double mean, double dispersion) const;
+    HistInfo analyzeHistogram(double minValue, double maxValue, const QVector<int> &values,
+                              double expectedValue, double dispersion) const;
+    double calculateCriticalX(double probability, int degrees_of_freedom) const;
 
 private:
     QVector<double> _randomValues;
@@ -1,9 +1,11 @@
 #ifndef CHARTVIEW_H
 #define CHARTVIEW_H
-
 #include <QChartView>
+#include <QSharedPointer>
 
-namespace QtCharts {class QChart; };
+namespace QtCharts {class QChart; class QXYSeries; class QBarSet; class QBarCategoryAxis; class QValueAxis; class QLineSeries; };
+class HistogramPyramid;
+class KernelDensity;
 
 class ChartView : public QtCharts::QChartView
 {
@@ -13,17 +15,65 @@ public:
     ChartView(QWidget * parent = nullptr);
     ChartView(QtCharts::QChart * chart, QWidget * parent = nullptr);
 
+    /// Порог числа точек, выше которого серия рисуется через OpenGL.
+    static constexpr int openGLThreshold = 10000;
+    /// Порог числа точек, выше которого анимация графика отключается.
+    static constexpr int animationThreshold = 2000;
+
+    /**
+     * Заменяет точки серии одним вызовом replace() и выбирает режим
+     * отрисовки по их количеству. Для прореженной серии sourceSize - число
+     * точек до прореживания. Серия должна быть уже добавлена на график.
+     */
+    static void setSeriesPoints(QtCharts::QXYSeries *series, const QVector<QPointF> &points, int sourceSize = -1);
+
+    /**
+     * Включает перестроение гистограммы при масштабировании: видимый участок
+     * выводится с числом интервалов, соответствующим ширине графика.
+     * Кривая строится по оценке плотности в масштабе столбцов, а без нее
+     * соединяет вершины столбцов.
+     */
+    void setHistogram(QSharedPointer<HistogramPyramid> pyramid,
+                      QtCharts::QBarSet *set,
+                      QtCharts::QBarCategoryAxis *categoryAxis,
+                      QtCharts::QValueAxis *dataAxis,
+                      QtCharts::QLineSeries *curve = nullptr,
+                      QSharedPointer<KernelDensity> density = {});
+
+    /**
+     * Заменяет гистограмму всего диапазона, например при смене числа интервалов,
+     * и возвращает график к полному диапазону.
+     */
+    void setBaseHistogram(const QVector<int> &counts);
+
 protected:
     void wheelEvent(QWheelEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
 
+private:
+    void setVisibleRange(double from, double to);
+    void renderHistogram();
+    void showHistogram(const QList<qreal> &values, const QStringList &labels, double from, double to);
+    QVector<QPointF> curvePoints(const QList<qreal> &values, double from, double to) const;
+
 private:
     bool isDragging = false;
     QPoint lastMousePos;
     double currentZoom = 0.5;
-};
 
+    QSharedPointer<HistogramPyramid> pyramid;
+    QtCharts::QBarSet *barSet = nullptr;
+    QtCharts::QBarCategoryAxis *categoryAxis = nullptr;
+    QtCharts::QValueAxis *dataAxis = nullptr;
+    QtCharts::QLineSeries *curve = nullptr;
+    QSharedPointer<KernelDensity> density;
+
+    QList<qreal> baseValues;
+    QStringList baseLabels;
+    double visibleFrom = 0.0;
+    double visibleTo = 0.0;
+};
 
 #endif // CHARTVIEW_H
@@ -0,0 +1,46 @@
+#ifndef HISTOGRAMPYRAMID_H
+#define HISTOGRAMPYRAMID_H
+
+#include <QVector>
+#include "statisticsaccumulator.h"
+
+struct HistogramSlice
+{
+    double start = 0.0;         ///< Левая граница первого интервала
+    double binWidth = 0.0;      ///< Ширина интервала
+    QVector<int> counts;        ///< Количество элементов в интервалах
+};
+
+/**
+ * @brief Многоуровневая гистограмма выборки.
+ * @details Выборка просматривается один раз при построении самого мелкого
+ * уровня из finestBins интервалов, каждый следующий уровень получается
+ * слиянием пар соседних интервалов. Запрос видимого участка выбирает уровень,
+ * на котором участок укладывается в заданное число интервалов, и стоит
+ * O(число видимых интервалов).
+ */
+class HistogramPyramid
+{
+public:
+    static constexpr int finestBins = 1024;
+
+    explicit HistogramPyramid(const QVector<double> &data);
+
+    /// Выборка просматривается блоками один раз, крайние значения должны быть известны.
+    HistogramPyramid(const SampleShard &sample, double minimum, double maximum);
+
+    double minimum() const { return _min; }
+    double maximum() const { return _max; }
+
+    HistogramSlice slice(double from, double to, int maxBins) const;
+
+private:
+    void build(const SampleShard &sample);
+
+private:
+    double _min = 0.0;
+    double _max = 0.0;
+    QVector<QVector<int>> _levels;    ///< _levels[0] - самый мелкий уровень
+};
+
+#endif // HISTOGRAMPYRAMID_H
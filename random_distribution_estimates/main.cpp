@@ -1,11 +1,284 @@
 #include "widget.h"
+#include "tracing.h"
+#include "allocationpanel.h"
+#include "perfgate.h"
+#include "normalkernel.h"
+#include "samplefile.h"
+#include "shardcoordinator.h"
 
 #include <QApplication>
+#include <QDebug>
+#include <QSharedPointer>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace
+{
+QVector<PerfGate::Scenario> perfScenarios()
+{
+    // Фиксированная нормальная выборка вместо файла с данными варианта.
+    std::mt19937 generator(10);
+    std::normal_distribution<double> distribution;
+    QVector<double> data(1000);
+    for (auto &value : data)
+        value = distribution(generator);
+
+    // Границы интервалов для пакетного расчета Φ, как в проверках согласия.
+    QVector<double> edges(1000000);
+    for (int i = 0; i < edges.size(); i++)
+        edges[i] = -8.0 + 16.0 * i / (edges.size() - 1);
+
+    // Большая выборка во float для специализированных гистограмм.
+    QVector<float> floatSample(1000000);
+    for (auto &value : floatSample)
+        value = distribution(generator);
+
+    auto unit = QSharedPointer<CalcUnit>::create(data);
+    return {{"chi_square_table", [unit, data]()
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            BinnedSample sample(data);
+            for (int ranges : {5, 7})
+                unit->getHistogramAnalysis(sample, ranges);
+        }
+    }},
+    {"normal_cdf_batch", [edges, probabilities = QVector<double>(edges.size())]() mutable
+    {
+        NormalKernel::cdf(edges.constData(), probabilities.data(), edges.size(), 0.0, 1.0);
+    }},
+    {"float_histograms", [unit, floatSample]()
+    {
+        for (int ranges : {5, 7})
+            unit->createHistogramSet(floatSample, ranges);
+    }}};
+}
+
+QString number(double value)
+{
+    return QString::number(value, 'g', 12);
+}
+
+/**
+ * Сверка NormalKernel с эталоном boost::math на равномерной сетке с допусками
+ * из normalkernel.h. У erfc допуск не меньше наименьшего нормального double:
+ * за порогом обнуления эталон меньше него.
+ */
+int runVerification()
+{
+    constexpr int count = 800001;
+    QVector<double> x(count);
+    for (int i = 0; i < count; i++)
+        x[i] = -40.0 + 80.0 * i / (count - 1);
+
+    QTextStream out(stdout);
+    out << "function\tparameters\tmax_error_to_tolerance\tat_x\n";
+    bool passed = true;
+    auto report = [&out, &passed](const QString &name, const QString &parameters, double worst, double worstX)
+    {
+        out << name << '\t' << parameters << '\t' << number(worst) << '\t' << number(worstX) << '\n';
+        passed = passed && worst <= 1.0;
+    };
+
+    QVector<double> values(count);
+    NormalKernel::erfc(x.constData(), values.data(), count);
+    double worst = 0.0;
+    double worstX = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        double exact = NormalKernel::exactErfc(x[i]);
+        double tolerance = std::max(1e-15 * (1.0 + x[i] * x[i]) * exact, std::numeric_limits<double>::min());
+        double error = std::abs(values[i] - exact) / tolerance;
+        if (!(error <= worst))
+        {
+            worst = error;
+            worstX = x[i];
+        }
+    }
+    report("erfc", "-", worst, worstX);
+
+    for (const auto &parameters : {std::make_pair(0.0, 1.0), std::make_pair(2.5, 0.3), std::make_pair(-10.0, 7.0)})
+    {
+        NormalKernel::cdf(x.constData(), values.data(), count, parameters.first, parameters.second);
+        worst = 0.0;
+        worstX = 0.0;
+        for (int i = 0; i < count; i++)
+        {
+            double error = std::abs(values[i] - NormalKernel::exactCdf(x[i], parameters.first, parameters.second)) / 4e-16;
+            if (!(error <= worst))
+            {
+                worst = error;
+                worstX = x[i];
+            }
+        }
+        report("cdf", number(parameters.first) + ' ' + number(parameters.second), worst, worstX);
+    }
+    return passed ? 0 : 1;
+}
+
+void printAnalysis(const Statistics &stats, const QVector<HistInfo> &analysis)
+{
+    QTextStream out(stdout);
+    out << "expectedValue\t" << number(stats.expectedValue) << '\n'
+        << "dispersion\t" << number(stats.dispersion) << '\n'
+        << "median\t" << number(stats.median) << '\n'
+        << "mode\t" << number(stats.modeValue) << '\n'
+        << "densityMode\t" << number(stats.densityMode) << '\n'
+        << "standardDeviation\t" << number(stats.standardDeviation) << '\n'
+        << "skewness\t" << number(stats.skewness) << '\n'
+        << "kurtosis\t" << number(stats.kurtosis) << '\n'
+        << "standardError\t" << number(stats.standartError) << '\n'
+        << "confidenceInterval\t" << number(stats.confidenceInterval.first) << '\t'
+        << number(stats.confidenceInterval.second) << '\n';
+
+    for (const auto &info : analysis)
+    {
+        out << "\nranges\tstart\tend\tcount\tprobability\texpected\tchi2\n";
+        for (int i = 0; i < info.values.size(); i++)
+        {
+            out << info.values.size() << '\t' << number(info.ranges[i].first) << '\t'
+                << number(info.ranges[i].second) << '\t' << info.values[i] << '\t'
+                << number(info.probabilities[i]) << '\t' << number(info.muliplyProbabilities[i]) << '\t'
+                << number(info.results[i]) << '\n';
+        }
+        out << "x_crit\t" << number(info.x_crit) << '\n';
+    }
+}
+
+int runAnalysis(const QStringList &arguments)
+{
+    QStringList files;
+    int workers = 0;
+    bool useFloat = false;
+    QVector<int> rangesList = {5, 7};
+    for (int i = arguments.indexOf("--analyze") + 1; i < arguments.size(); i++)
+    {
+        if (arguments[i] == "--workers" && i + 1 < arguments.size())
+            workers = arguments[++i].toInt();
+        else if (arguments[i] == "--float")
+            useFloat = true;
+        else if (arguments[i] == "--ranges" && i + 1 < arguments.size())
+        {
+            rangesList.clear();
+            for (const auto &value : arguments[++i].split(','))
+                rangesList.append(value.toInt());
+        }
+        else
+            files.append(arguments[i]);
+    }
+
+    if (files.isEmpty() || rangesList.isEmpty())
+    {
+        qDebug() << "Usage: --analyze <file>... [--workers N] [--ranges 5,7] [--float]";
+        return 1;
+    }
+
+    // Характеристики считаются по последнему числу интервалов, как в окне программы.
+    Statistics stats;
+    QVector<HistInfo> analysis;
+    if (workers > 0)
+    {
+        ShardCoordinator coordinator(files, workers);
+        if (!coordinator.start())
+            return 1;
+
+        CalcUnit unit{QVector<double>()};
+        auto pass = [&coordinator](const AccumulatorLayout &layout) { return coordinator.pass(layout); };
+        stats = unit.calculateStatistics(pass, rangesList.last());
+        analysis = unit.getHistogramAnalysis(pass, rangesList);
+        if (coordinator.hasFailed())
+            return 1;
+    }
+    else if (useFloat)
+    {
+        // Выборка хранится во float, файлы переводятся по одному.
+        QVector<float> data;
+        for (const auto &file : qAsConst(files))
+        {
+            QVector<double> values;
+            if (!SampleFile::read(file, values))
+                return 1;
+            data.reserve(data.size() + values.size());
+            for (double value : qAsConst(values))
+                data.append(static_cast<float>(value));
+        }
+
+        CalcUnit unit{QVector<double>()};
+        stats = unit.calculateStatistics(data, rangesList.last());
+        analysis = unit.getHistogramAnalysis(data, rangesList);
+    }
+    else
+    {
+        QVector<double> data;
+        for (const auto &file : qAsConst(files))
+        {
+            QVector<double> values;
+            if (!SampleFile::read(file, values))
+                return 1;
+            data += values;
+        }
+
+        CalcUnit unit(data);
+        stats = unit.calculateStatistics(data, rangesList.last());
+        analysis = unit.getHistogramAnalysis(data, rangesList);
+    }
+
+    printAnalysis(stats, analysis);
+    if (AllocationStats::isEnabled())
+        QTextStream(stdout) << '\n' << AllocationStats::formatReport();
+    return 0;
+}
+}
 
 int main(int argc, char *argv[])
 {
+    // Исполнитель распределенного расчета, запускается координатором
+    if (ShardCoordinator::isWorker(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+        return ShardCoordinator::runWorker(argc, argv);
+    }
+
+    // DATAANALYS_TRACE=<файл>: запись трассировки в формате Chrome trace при выходе
+    Tracing::enableFromEnvironment();
+    // DATAANALYS_ALLOC_STATS=1: учет памяти по этапам, панель по F12
+    AllocationStats::enableFromEnvironment();
+
+    // --perf-gate <база> / --perf-baseline <база>: проверка производительности без интерфейса
+    if (PerfGate::isRequested(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+        return PerfGate::run(argc, argv, perfScenarios());
+    }
+
+    // --verify: сверка пакетного Φ и erfc с boost::math, код завершения 1 при расхождении
+    for (int i = 1; i < argc; i++)
+    {
+        if (QString(argv[i]) == "--verify")
+        {
+            QCoreApplication a(argc, argv);
+            return runVerification();
+        }
+    }
+
+    // --analyze <файлы> [--workers N] [--ranges 5,7] [--float]: расчет без интерфейса,
+    // при N > 0 файлы делятся между N процессами-исполнителями,
+    // с --float выборка в одном процессе хранится во float
+    for (int i = 1; i < argc; i++)
+    {
+        if (QString(argv[i]) == "--analyze")
+        {
+            QCoreApplication a(argc, argv);
+            return runAnalysis(a.arguments());
+        }
+    }
+
     QApplication a(argc, argv);
     Widget w;
+    AllocationPanel::install(&w);
     w.show();
     return a.exec();
 }
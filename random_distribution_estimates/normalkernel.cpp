@@ -0,0 +1,206 @@
+#include "normalkernel.h"
+#include "tracing.h"
+#include <boost/math/distributions/normal.hpp>
+#include <boost/math/special_functions/erf.hpp>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NORMALKERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+constexpr double scaleK = 3.5;
+
+/// Коэффициенты ряда Чебышёва erfcx(z) по t = (z - scaleK) / (z + scaleK).
+constexpr int seriesSize = 27;
+constexpr double series[seriesSize] = {
+    0.312623801551655,
+    -0.44084753071180292,
+    0.17181431344409017,
+    -0.055832842231794467,
+    0.01502267215259511,
+    -0.0032641939881747373,
+    0.0005390059133983518,
+    -5.6479369091502362e-5,
+    3.4961512125906757e-7,
+    1.0543363198198797e-6,
+    -1.4704494089405748e-7,
+    -7.8871847919820091e-9,
+    4.4818663935657393e-9,
+    -1.5906948259894791e-10,
+    -1.1689383426881348e-10,
+    1.1251509135116535e-11,
+    3.2056390449979667e-12,
+    -4.7054177500228892e-13,
+    -1.0078278428026654e-13,
+    1.7727012021163777e-14,
+    3.7416073851568715e-15,
+    -6.3859960827822094e-16,
+    -1.6014801967252788e-16,
+    2.138350174479367e-17,
+    7.4809321054728256e-18,
+    -5.8115425659147904e-19,
+    -3.765861417706107e-19,
+};
+
+/// Выше этого z exp(-z²) меньше наименьшего нормализованного double.
+constexpr double underflowLimit = 26.6;
+
+inline double erfcScalar(double x)
+{
+    double z = std::fabs(x);
+    double t = (z - scaleK) / (z + scaleK);
+
+    // Схема Кленшоу
+    double b1 = 0.0;
+    double b2 = 0.0;
+    for (int k = seriesSize - 1; k > 0; k--)
+    {
+        double b = 2.0 * t * b1 - b2 + series[k];
+        b2 = b1;
+        b1 = b;
+    }
+    double erfcx = t * b1 - b2 + series[0];
+
+    double value = z > underflowLimit ? 0.0 : std::exp(-z * z) * erfcx;
+    return x < 0 ? 2.0 - value : value;
+}
+
+#ifdef NORMALKERNEL_SSE2
+/// exp(x) при x из [-708, 0]: 2^k · многочлен Тейлора 13-й степени на |r| <= ln2 / 2.
+inline __m128d expNegative(__m128d x)
+{
+    const __m128d shifter = _mm_set1_pd(6755399441055744.0);   // 1.5 · 2^52
+    x = _mm_max_pd(x, _mm_set1_pd(-708.0));
+
+    __m128d shifted = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(1.4426950408889634)), shifter);
+    __m128d k = _mm_sub_pd(shifted, shifter);
+    __m128d r = _mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(0.693147180369123816490)));
+    r = _mm_sub_pd(r, _mm_mul_pd(k, _mm_set1_pd(1.90821492927058770002e-10)));
+
+    __m128d p = _mm_set1_pd(1.0 / 6227020800.0);
+    const double taylor[] = {1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0,
+                             1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0,
+                             1.0 / 6.0, 0.5, 1.0, 1.0};
+    for (double coefficient : taylor)
+        p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(coefficient));
+
+    // Младшие биты сдвинутого значения содержат k, из них собирается порядок 2^k.
+    __m128i exponent = _mm_add_epi64(_mm_castpd_si128(shifted), _mm_set1_epi64x(1023));
+    return _mm_mul_pd(p, _mm_castsi128_pd(_mm_slli_epi64(exponent, 52)));
+}
+
+/**
+ * erfc для lanes пар значений. Ряд Кленшоу - цепочка зависимых операций,
+ * несколько независимых пар за проход скрывают ее задержку.
+ */
+template<int lanes>
+inline void erfcPairs(__m128d (&x)[lanes])
+{
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d k = _mm_set1_pd(scaleK);
+
+    __m128d z[lanes], t[lanes], twoT[lanes], b1[lanes], b2[lanes];
+    for (int j = 0; j < lanes; j++)
+    {
+        // Бесконечность дала бы t = NaN, NaN сохраняется: _mm_min_pd возвращает второй аргумент.
+        z[j] = _mm_min_pd(_mm_set1_pd(underflowLimit + 1.0), _mm_andnot_pd(signMask, x[j]));
+        t[j] = _mm_div_pd(_mm_sub_pd(z[j], k), _mm_add_pd(z[j], k));
+        twoT[j] = _mm_add_pd(t[j], t[j]);
+        b1[j] = _mm_setzero_pd();
+        b2[j] = _mm_setzero_pd();
+    }
+
+    for (int i = seriesSize - 1; i > 0; i--)
+    {
+        const __m128d coefficient = _mm_set1_pd(series[i]);
+        for (int j = 0; j < lanes; j++)
+        {
+            __m128d b = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(twoT[j], b1[j]), b2[j]), coefficient);
+            b2[j] = b1[j];
+            b1[j] = b;
+        }
+    }
+
+    for (int j = 0; j < lanes; j++)
+    {
+        __m128d erfcx = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(t[j], b1[j]), b2[j]), _mm_set1_pd(series[0]));
+        __m128d value = _mm_mul_pd(expNegative(_mm_sub_pd(_mm_setzero_pd(), _mm_mul_pd(z[j], z[j]))), erfcx);
+        value = _mm_andnot_pd(_mm_cmpgt_pd(z[j], _mm_set1_pd(underflowLimit)), value);
+
+        __m128d negative = _mm_cmplt_pd(x[j], _mm_setzero_pd());
+        __m128d reflected = _mm_sub_pd(_mm_set1_pd(2.0), value);
+        x[j] = _mm_or_pd(_mm_and_pd(negative, reflected), _mm_andnot_pd(negative, value));
+    }
+}
+
+/// Независимых пар за проход: больше не помещается в 16 регистров XMM.
+constexpr int pairLanes = 4;
+constexpr int blockSize = 2 * pairLanes;
+#endif
+}
+
+namespace NormalKernel
+{
+void erfc(const double *x, double *result, int count)
+{
+    int i = 0;
+#ifdef NORMALKERNEL_SSE2
+    for (; i + blockSize <= count; i += blockSize)
+    {
+        __m128d pairs[pairLanes];
+        for (int j = 0; j < pairLanes; j++)
+            pairs[j] = _mm_loadu_pd(x + i + 2 * j);
+        erfcPairs(pairs);
+        for (int j = 0; j < pairLanes; j++)
+            _mm_storeu_pd(result + i + 2 * j, pairs[j]);
+    }
+#endif
+    for (; i < count; i++)
+        result[i] = erfcScalar(x[i]);
+}
+
+void cdf(const double *x, double *result, int count, double mean, double deviation)
+{
+    // Φ(x) = erfc(-(x - mean) / (deviation·√2)) / 2
+    const double scale = -1.0 / (deviation * std::sqrt(2.0));
+    int i = 0;
+#ifdef NORMALKERNEL_SSE2
+    const __m128d meanPair = _mm_set1_pd(mean);
+    const __m128d scalePair = _mm_set1_pd(scale);
+    const __m128d half = _mm_set1_pd(0.5);
+    for (; i + blockSize <= count; i += blockSize)
+    {
+        __m128d pairs[pairLanes];
+        for (int j = 0; j < pairLanes; j++)
+            pairs[j] = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(x + i + 2 * j), meanPair), scalePair);
+        erfcPairs(pairs);
+        for (int j = 0; j < pairLanes; j++)
+            _mm_storeu_pd(result + i + 2 * j, _mm_mul_pd(pairs[j], half));
+    }
+#endif
+    for (; i < count; i++)
+        result[i] = 0.5 * erfcScalar((x[i] - mean) * scale);
+}
+
+QVector<double> cdf(const QVector<double> &x, double mean, double deviation)
+{
+    TRACE_SPAN("NormalKernel::cdf");
+    QVector<double> result(x.size());
+    cdf(x.constData(), result.data(), x.size(), mean, deviation);
+    return result;
+}
+
+double exactErfc(double x)
+{
+    return boost::math::erfc(x);
+}
+
+double exactCdf(double x, double mean, double deviation)
+{
+    return boost::math::cdf(boost::math::normal_distribution<>(mean, deviation), x);
+}
+}
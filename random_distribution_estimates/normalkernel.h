@@ -0,0 +1,32 @@
+#ifndef NORMALKERNEL_H
+#define NORMALKERNEL_H
+
+#include <QVector>
+
+/**
+ * @brief Пакетный расчет функции нормального распределения Φ(x) и erfc(x).
+ * @details erfc(z) при z >= 0 считается как exp(-z²)·erfcx(z), где erfcx
+ * приближена одним рядом Чебышёва 26-й степени по t = (z - 3.5) / (z + 3.5).
+ * Ветвлений по диапазонам нет, поэтому на x86 значения считаются по два за
+ * инструкцию SSE2 вместе с собственной экспонентой, остаток массива и другие
+ * платформы - тем же рядом со std::exp.
+ *
+ * Погрешность относительно boost::math (exactErfc, exactCdf): у erfc
+ * относительная не больше 1e-15·(1 + x²), рост дает округление x² в exp;
+ * при |x| > 26.6 значение меньше 1e-307 и обнуляется. У Φ абсолютная
+ * не больше 4e-16. Допуски проверяются ключом --verify.
+ */
+namespace NormalKernel
+{
+void erfc(const double *x, double *result, int count);
+
+/// Φ((x - mean) / deviation) для каждого x, результат может совпадать с x.
+void cdf(const double *x, double *result, int count, double mean, double deviation);
+QVector<double> cdf(const QVector<double> &x, double mean, double deviation);
+
+/// Эталонные значения boost::math для проверки ядра.
+double exactErfc(double x);
+double exactCdf(double x, double mean, double deviation);
+}
+
+#endif // NORMALKERNEL_H
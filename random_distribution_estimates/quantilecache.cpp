@@ -0,0 +1,90 @@
+#include "quantilecache.h"
+
+#include <boost/math/distributions/students_t.hpp>
+#include <boost/math/distributions/chi_squared.hpp>
+
+#include <array>
+#include <atomic>
+
+namespace
+{
+const std::array<double, 6> tableProbabilities = {0.1, 0.05, 0.025, 0.01, 0.005, 0.001};
+
+/**
+ * Значение таблицы, 0 - еще не вычислено: при степенях свободы от 1 и уровне
+ * меньше 0.5 оба квантиля положительны. Статический массив обнулен до первого
+ * обращения, гонка двух потоков приводит лишь к повторному вычислению.
+ */
+std::atomic<double> &tableEntry(int distribution, int index, int degreesOfFreedom)
+{
+    constexpr int rowSize = QuantileCache::maxTableDegrees + 1;
+    static std::array<std::atomic<double>, 2 * tableProbabilities.size() * rowSize> entries;
+    return entries[(distribution * tableProbabilities.size() + index) * rowSize + degreesOfFreedom];
+}
+}
+
+double QuantileCache::chiSquared(double probability, int degreesOfFreedom)
+{
+    return lookup(ChiSquared, probability, degreesOfFreedom);
+}
+
+double QuantileCache::student(double probability, int degreesOfFreedom)
+{
+    return lookup(Student, probability, degreesOfFreedom);
+}
+
+double QuantileCache::exactChiSquared(double probability, int degreesOfFreedom)
+{
+    boost::math::chi_squared dist(degreesOfFreedom);
+    return quantile(dist, 1 - probability);
+}
+
+double QuantileCache::exactStudent(double probability, int degreesOfFreedom)
+{
+    boost::math::students_t dist(degreesOfFreedom);
+    return quantile(dist, 1 - probability);
+}
+
+double QuantileCache::lookup(Distribution distribution, double probability, int degreesOfFreedom)
+{
+    int index = tableIndex(probability);
+    if (index >= 0 && degreesOfFreedom >= 1 && degreesOfFreedom <= maxTableDegrees)
+    {
+        auto &entry = tableEntry(distribution, index, degreesOfFreedom);
+        double value = entry.load(std::memory_order_relaxed);
+        if (value == 0.0)
+        {
+            value = exact(distribution, probability, degreesOfFreedom);
+            entry.store(value, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    static QMutex mutex;
+    static QHash<std::pair<double, int>, double> memo[2];
+
+    QMutexLocker locker(&mutex);
+    auto &cache = memo[distribution];
+    auto key = std::make_pair(probability, degreesOfFreedom);
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it.value();
+
+    double value = exact(distribution, probability, degreesOfFreedom);
+    cache.insert(key, value);
+    return value;
+}
+
+double QuantileCache::exact(Distribution distribution, double probability, int degreesOfFreedom)
+{
+    return distribution == ChiSquared ? exactChiSquared(probability, degreesOfFreedom)
+                                      : exactStudent(probability, degreesOfFreedom);
+}
+
+int QuantileCache::tableIndex(double probability)
+{
+    for (size_t i = 0; i < tableProbabilities.size(); i++)
+        if (tableProbabilities[i] == probability)
+            return static_cast<int>(i);
+    return -1;
+}
@@ -0,0 +1,36 @@
+#ifndef QUANTILECACHE_H
+#define QUANTILECACHE_H
+
+#include <QHash>
+#include <QMutex>
+
+/**
+ * @brief Кэш критических значений распределений хи-квадрат и Стьюдента.
+ * @details Для распространенных уровней значимости и числа степеней свободы
+ * 1..maxTableDegrees значения хранятся в таблицах, каждое значение таблицы
+ * вычисляется один раз при первом обращении к нему, без блокировок. Остальные пары (уровень, степени
+ * свободы) запоминаются после первого вычисления. Точные значения через boost
+ * доступны как эталон.
+ */
+class QuantileCache
+{
+public:
+    static constexpr int maxTableDegrees = 1000;
+
+    /// Критическое значение хи-квадрат: квантиль уровня 1 - probability.
+    static double chiSquared(double probability, int degreesOfFreedom);
+    /// Критическое значение Стьюдента: квантиль уровня 1 - probability.
+    static double student(double probability, int degreesOfFreedom);
+
+    static double exactChiSquared(double probability, int degreesOfFreedom);
+    static double exactStudent(double probability, int degreesOfFreedom);
+
+private:
+    enum Distribution { ChiSquared = 0, Student = 1 };
+
+    static double lookup(Distribution distribution, double probability, int degreesOfFreedom);
+    static double exact(Distribution distribution, double probability, int degreesOfFreedom);
+    static int tableIndex(double probability);
+};
+
+#endif // QUANTILECACHE_H
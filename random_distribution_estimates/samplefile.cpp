@@ -0,0 +1,247 @@
+#include "samplefile.h"
+
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/// Меньшие файлы разбираются в одном потоке.
+constexpr qint64 minChunkSize = 1 << 20;
+
+/// Количество значений, форматируемых потоком за один раз.
+constexpr int writeBlockSize = 1 << 16;
+
+/// Самая длинная запись числа в формате %.6g, например "-1.23457e-308".
+constexpr int maxValueLength = 16;
+
+#ifdef Q_OS_WIN
+const char lineEnd[] = "\r\n";
+#else
+const char lineEnd[] = "\n";
+#endif
+constexpr int lineEndLength = sizeof(lineEnd) - 1;
+
+struct Chunk
+{
+    const char *begin;
+    const char *end;
+    int lines = 0;              ///< Количество строк в части
+    int errorLine = -1;         ///< Номер ошибочной строки внутри части
+    const char *errorBegin = nullptr;
+    const char *errorEnd = nullptr;
+};
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/// Количество строк в части; последняя строка может не оканчиваться переводом строки.
+int countLines(const char *begin, const char *end)
+{
+    int lines = 0;
+    for (auto it = begin; it != end; lines++)
+    {
+        auto next = static_cast<const char *>(std::memchr(it, '\n', end - it));
+        it = next ? next + 1 : end;
+    }
+    return lines;
+}
+
+void parseChunk(Chunk &chunk, double *output)
+{
+    int line = 0;
+    for (auto it = chunk.begin; it != chunk.end; line++)
+    {
+        // Строка не ищется заранее: число разбирается с ее начала, а затем
+        // проверяется, что за ним до перевода строки нет ничего, кроме пробелов.
+        auto first = it;
+        while (first != chunk.end && (*first == ' ' || *first == '\t'))
+            first++;
+        if (first != chunk.end && *first == '+')
+            first++;
+
+        auto result = std::from_chars(first, chunk.end, output[line]);
+        auto last = result.ptr;
+        while (last != chunk.end && isSpace(*last))
+            last++;
+
+        if (result.ec != std::errc() || (last != chunk.end && *last != '\n'))
+        {
+            auto lineEnd = static_cast<const char *>(std::memchr(it, '\n', chunk.end - it));
+            chunk.errorLine = line;
+            chunk.errorBegin = it;
+            chunk.errorEnd = lineEnd ? lineEnd : chunk.end;
+            return;
+        }
+
+        it = last == chunk.end ? last : last + 1;
+    }
+}
+
+/// Форматирует значения в буфер, возвращает количество записанных байт.
+size_t formatBlock(const double *values, int count, char *buffer)
+{
+    char *out = buffer;
+    for (int i = 0; i < count; i++)
+    {
+        out = std::to_chars(out, out + maxValueLength, values[i], std::chars_format::general, 6).ptr;
+        std::memcpy(out, lineEnd, lineEndLength);
+        out += lineEndLength;
+    }
+    return out - buffer;
+}
+}
+
+namespace SampleFile
+{
+ParseResult parse(const char *begin, const char *end, int threads)
+{
+    ParseResult result;
+
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<int>(std::max<qint64>(1, std::min<qint64>(threads, (end - begin) / minChunkSize)));
+
+    // Границы частей сдвигаются к началу следующей строки.
+    std::vector<Chunk> chunks;
+    auto chunkBegin = begin;
+    for (int i = 0; i < threads && chunkBegin != end; i++)
+    {
+        auto chunkEnd = i == threads - 1 ? end : begin + (end - begin) * (i + 1) / threads;
+        if (chunkEnd < chunkBegin)
+            chunkEnd = chunkBegin;
+        auto next = static_cast<const char *>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+        chunkEnd = next ? next + 1 : end;
+
+        chunks.push_back({chunkBegin, chunkEnd});
+        chunkBegin = chunkEnd;
+    }
+
+    auto runParallel = [&chunks](auto task)
+    {
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < chunks.size(); i++)
+            workers.emplace_back(task, i);
+        if (!chunks.empty())
+            task(0);
+        for (auto &worker : workers)
+            worker.join();
+    };
+
+    // Первый проход считает строки, чтобы каждая часть писала сразу в свой участок результата.
+    runParallel([&chunks](size_t i) { chunks[i].lines = countLines(chunks[i].begin, chunks[i].end); });
+
+    std::vector<int> offsets(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); i++)
+        offsets[i + 1] = offsets[i] + chunks[i].lines;
+
+    result.values.resize(offsets.back());
+    double *output = result.values.data();
+    runParallel([&chunks, &offsets, output](size_t i) { parseChunk(chunks[i], output + offsets[i]); });
+
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        if (chunks[i].errorLine < 0)
+            continue;
+
+        result.errorLine = offsets[i] + chunks[i].errorLine + 1;
+        result.errorText = QString::fromUtf8(chunks[i].errorBegin, static_cast<int>(chunks[i].errorEnd - chunks[i].errorBegin));
+        result.values.clear();
+        break;
+    }
+    return result;
+}
+
+bool read(const QString &filePath, QVector<double> &values)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Failed to open file for reading:" << filePath;
+        return false;
+    }
+
+    ParseResult result;
+    if (file.size() > 0)
+    {
+        auto data = reinterpret_cast<const char *>(file.map(0, file.size()));
+        if (data)
+        {
+            result = parse(data, data + file.size());
+            file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+        }
+        else
+        {
+            auto bytes = file.readAll();
+            result = parse(bytes.constData(), bytes.constData() + bytes.size());
+        }
+    }
+    file.close();
+
+    if (!result.isValid())
+    {
+        qDebug() << "Failed to convert line" << result.errorLine << "to double:" << result.errorText;
+        return false;
+    }
+
+    values = result.values;
+    return true;
+}
+
+bool write(const QString &filePath, const QVector<double> &values, int threads)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Failed to open file for writing:" << filePath << file.errorString();
+        return false;
+    }
+
+    const int blocks = (values.size() + writeBlockSize - 1) / writeBlockSize;
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, blocks));
+
+    // Каждый поток форматирует свой блок в собственный буфер, после чего
+    // буферы записываются в файл в порядке блоков.
+    const size_t bufferSize = static_cast<size_t>(writeBlockSize) * (maxValueLength + lineEndLength);
+    std::vector<std::vector<char>> buffers(threads, std::vector<char>(bufferSize));
+    std::vector<size_t> lengths(threads, 0);
+
+    for (int round = 0; round < blocks; round += threads)
+    {
+        const int roundBlocks = std::min(threads, blocks - round);
+        auto task = [&](int i)
+        {
+            int first = (round + i) * writeBlockSize;
+            int count = std::min(writeBlockSize, values.size() - first);
+            lengths[i] = formatBlock(values.constData() + first, count, buffers[i].data());
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 1; i < roundBlocks; i++)
+            workers.emplace_back(task, i);
+        task(0);
+        for (auto &worker : workers)
+            worker.join();
+
+        for (int i = 0; i < roundBlocks; i++)
+        {
+            if (file.write(buffers[i].data(), static_cast<qint64>(lengths[i])) != static_cast<qint64>(lengths[i]))
+            {
+                qDebug() << "Failed to write file:" << filePath << file.errorString();
+                return false;
+            }
+        }
+    }
+
+    file.close();
+    return true;
+}
+}
@@ -0,0 +1,45 @@
+#ifndef SAMPLEFILE_H
+#define SAMPLEFILE_H
+
+#include <QVector>
+#include <QString>
+
+/**
+ * @brief Чтение и запись текстовых файлов выборок (одно число в строке).
+ * @details При чтении файл отображается в память и делится по границам строк
+ * между потоками. Числа разбираются std::from_chars: без учета локали, без
+ * перекодирования в UTF-16 и без выделения памяти на каждую строку.
+ * При записи блоки значений форматируются std::to_chars в буферы потоков
+ * и записываются по порядку крупными последовательными вызовами.
+ */
+namespace SampleFile
+{
+struct ParseResult
+{
+    QVector<double> values;     ///< Разобранные значения
+    int errorLine = 0;          ///< Номер первой ошибочной строки (с 1), 0 - ошибок нет
+    QString errorText;          ///< Содержимое ошибочной строки
+
+    bool isValid() const { return errorLine == 0; }
+};
+
+/**
+ * @param threads Количество потоков, 0 - по числу ядер.
+ */
+ParseResult parse(const char *begin, const char *end, int threads = 0);
+
+/**
+ * Читает файл выборки. При ошибке открытия или разбора пишет причину
+ * в отладочный вывод и возвращает false.
+ */
+bool read(const QString &filePath, QVector<double> &values);
+
+/**
+ * Записывает выборку в том же виде, что QTextStream << QString::number(value)
+ * в текстовом режиме: формат 'g' с 6 значащими цифрами, перевод строки платформы.
+ * @param threads Количество потоков форматирования, 0 - по числу ядер.
+ */
+bool write(const QString &filePath, const QVector<double> &values, int threads = 0);
+}
+
+#endif // SAMPLEFILE_H
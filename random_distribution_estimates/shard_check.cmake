@@ -0,0 +1,207 @@
+# Сравнение расчета --analyze в процессах-исполнителях с расчетом в одном процессе.
+# Запуск: cmake -DPROGRAM=<программа> -DWORK_DIR=<каталог> -P shard_check.cmake
+#
+# Выборки порождаются линейным конгруэнтным генератором, поэтому проверка
+# не зависит от файлов варианта. Мода плотности по эскизу отличается от
+# расчета в памяти в пределах шага эскиза и не сравнивается.
+#
+# Частоты, границы интервалов, медиана, мода и x_crit сравниваются точно.
+# Моменты объединяются по участкам в другом порядке суммирования, поэтому
+# они и зависящие от них вероятности, ожидаемые частоты и слагаемые хи-квадрат
+# сравниваются с относительной точностью 1e-9.
+
+cmake_minimum_required(VERSION 3.14)
+
+if(NOT PROGRAM OR NOT WORK_DIR)
+    message(FATAL_ERROR "Usage: cmake -DPROGRAM=<program> -DWORK_DIR=<dir> -P shard_check.cmake")
+endif()
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+# Значения из [-100, 100] с четырьмя знаками после точки, одно в строке.
+function(write_sample path seed count)
+    set(state ${seed})
+    set(content "")
+    foreach(i RANGE 1 ${count})
+        math(EXPR state "(${state} * 1103515245 + 12345) % 2147483648")
+        math(EXPR value "${state} % 2000001 - 1000000")
+        set(sign "")
+        if(value LESS 0)
+            set(sign "-")
+            math(EXPR value "-${value}")
+        endif()
+        math(EXPR whole "${value} / 10000")
+        math(EXPR fraction "${value} % 10000 + 10000")
+        string(SUBSTRING ${fraction} 1 4 fraction)
+        string(APPEND content "${sign}${whole}.${fraction}\n")
+    endforeach()
+    file(WRITE ${path} "${content}")
+endfunction()
+
+set(FILES ${WORK_DIR}/shard_a.txt ${WORK_DIR}/shard_b.txt)
+write_sample(${WORK_DIR}/shard_a.txt 17 1500)
+write_sample(${WORK_DIR}/shard_b.txt 29 1000)
+
+# Разбор числа в формате QString::number(v, 'g', 12): знак, цифры без ведущих нулей
+# и порядок младшей цифры. Нуль дает пустые цифры.
+function(parse_number text sign digits exponent)
+    if(NOT text MATCHES "^(-?)([0-9]*)\\.?([0-9]*)(e([-+][0-9]+))?$")
+        set(${digits} "x" PARENT_SCOPE)
+        return()
+    endif()
+    set(value_sign "${CMAKE_MATCH_1}")
+    set(fraction "${CMAKE_MATCH_3}")
+    set(value_digits "${CMAKE_MATCH_2}${fraction}")
+    set(value_exponent 0)
+    if(CMAKE_MATCH_5)
+        math(EXPR value_exponent "${CMAKE_MATCH_5}")
+    endif()
+    string(LENGTH "${fraction}" fraction_length)
+    math(EXPR value_exponent "${value_exponent} - ${fraction_length}")
+    string(REGEX REPLACE "^0+" "" value_digits "${value_digits}")
+    set(${sign} "${value_sign}" PARENT_SCOPE)
+    set(${digits} "${value_digits}" PARENT_SCOPE)
+    set(${exponent} ${value_exponent} PARENT_SCOPE)
+endfunction()
+
+# Числа совпадают с относительной точностью 1e-9 или оба меньше 1e-12 по модулю.
+function(numbers_close first second result)
+    set(${result} FALSE PARENT_SCOPE)
+    parse_number("${first}" sign_a digits_a exponent_a)
+    parse_number("${second}" sign_b digits_b exponent_b)
+    if(digits_a STREQUAL "x" OR digits_b STREQUAL "x")
+        return()
+    endif()
+
+    # Порядок старшей цифры, у нуля - меньше любого значимого. Цифры дополняются
+    # нулями до двенадцати, чтобы порядки младших цифр различались не больше чем на один.
+    foreach(name a b)
+        string(LENGTH "${digits_${name}}" length)
+        if(length EQUAL 0)
+            set(digits_${name} 0)
+            set(order_${name} -1000)
+        else()
+            math(EXPR order_${name} "${exponent_${name}} + ${length} - 1")
+            while(length LESS 12)
+                string(APPEND digits_${name} "0")
+                math(EXPR exponent_${name} "${exponent_${name}} - 1")
+                math(EXPR length "${length} + 1")
+            endwhile()
+        endif()
+    endforeach()
+    if(order_a LESS -12 AND order_b LESS -12)
+        set(${result} TRUE PARENT_SCOPE)
+        return()
+    endif()
+    if(order_a EQUAL -1000 OR order_b EQUAL -1000)
+        return()
+    endif()
+
+    # Приведение к общему порядку; при разнице порядков больше единицы числа далеки.
+    if(exponent_a LESS exponent_b)
+        math(EXPR shift "${exponent_b} - ${exponent_a}")
+        set(larger b)
+    else()
+        math(EXPR shift "${exponent_a} - ${exponent_b}")
+        set(larger a)
+    endif()
+    if(shift GREATER 1)
+        return()
+    endif()
+    while(shift GREATER 0)
+        string(APPEND digits_${larger} "0")
+        math(EXPR shift "${shift} - 1")
+    endwhile()
+
+    math(EXPR value_a "${sign_a}${digits_a}")
+    math(EXPR value_b "${sign_b}${digits_b}")
+    math(EXPR difference "${value_a} - ${value_b}")
+    if(difference LESS 0)
+        math(EXPR difference "-${difference}")
+    endif()
+    if(digits_a GREATER digits_b)
+        math(EXPR tolerance "${digits_a} / 1000000000")
+    else()
+        math(EXPR tolerance "${digits_b} / 1000000000")
+    endif()
+    if(NOT difference GREATER tolerance)
+        set(${result} TRUE PARENT_SCOPE)
+    endif()
+endfunction()
+
+# Построчное сравнение вывода, расхождения допускаются только в полях моментов.
+function(outputs_match first second result)
+    set(${result} FALSE PARENT_SCOPE)
+    string(REPLACE "\n" ";" lines_a "${first}")
+    string(REPLACE "\n" ";" lines_b "${second}")
+    list(LENGTH lines_a count)
+    list(LENGTH lines_b count_b)
+    if(NOT count EQUAL count_b)
+        return()
+    endif()
+
+    set(moments expectedValue dispersion standardDeviation skewness kurtosis
+                standardError confidenceInterval)
+    math(EXPR last "${count} - 1")
+    foreach(i RANGE 0 ${last})
+        list(GET lines_a ${i} line_a)
+        list(GET lines_b ${i} line_b)
+        if(line_a STREQUAL line_b)
+            continue()
+        endif()
+
+        string(REPLACE "\t" ";" fields_a "${line_a}")
+        string(REPLACE "\t" ";" fields_b "${line_b}")
+        list(LENGTH fields_a field_count)
+        list(LENGTH fields_b field_count_b)
+        if(NOT field_count EQUAL field_count_b)
+            return()
+        endif()
+
+        # Строка характеристики: все значения после имени; строка таблицы
+        # ranges/start/end/count/probability/expected/chi2: последние три поля.
+        list(GET fields_a 0 key)
+        if(key IN_LIST moments)
+            set(first_tolerant 1)
+        elseif(field_count EQUAL 7 AND key MATCHES "^[0-9]+$")
+            set(first_tolerant 4)
+        else()
+            return()
+        endif()
+
+        math(EXPR last_field "${field_count} - 1")
+        foreach(j RANGE 0 ${last_field})
+            list(GET fields_a ${j} field_a)
+            list(GET fields_b ${j} field_b)
+            if(field_a STREQUAL field_b)
+                continue()
+            endif()
+            if(j LESS first_tolerant)
+                return()
+            endif()
+            numbers_close("${field_a}" "${field_b}" close)
+            if(NOT close)
+                return()
+            endif()
+        endforeach()
+    endforeach()
+    set(${result} TRUE PARENT_SCOPE)
+endfunction()
+
+foreach(workers 0 2)
+    execute_process(COMMAND ${PROGRAM} --analyze ${FILES} --workers ${workers}
+                    RESULT_VARIABLE result
+                    OUTPUT_VARIABLE output_${workers}
+                    ERROR_VARIABLE errors)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "--workers ${workers} failed (${result}):\n${errors}")
+    endif()
+    string(REGEX REPLACE "densityMode\t[^\n]*\n" "" output_${workers} "${output_${workers}}")
+endforeach()
+
+outputs_match("${output_0}" "${output_2}" match)
+if(NOT match)
+    file(WRITE ${WORK_DIR}/shard_workers_0.txt "${output_0}")
+    file(WRITE ${WORK_DIR}/shard_workers_2.txt "${output_2}")
+    message(FATAL_ERROR "--workers 2 differs from --workers 0, see ${WORK_DIR}/shard_workers_*.txt")
+endif()
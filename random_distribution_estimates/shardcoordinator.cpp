@@ -0,0 +1,229 @@
+#include "shardcoordinator.h"
+#include "samplefile.h"
+#include "tracing.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QtEndian>
+#include <algorithm>
+#include <cstdio>
+
+#if defined(Q_OS_WIN)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+const char workerKey[] = "--shard-worker";
+
+/// Сообщение: длина в 8 байтах little-endian и содержимое.
+bool writeMessage(QIODevice &device, const QByteArray &payload)
+{
+    const qint64 size = qToLittleEndian<qint64>(payload.size());
+    return device.write(reinterpret_cast<const char *>(&size), sizeof(size)) == sizeof(size)
+           && device.write(payload) == payload.size();
+}
+
+bool readExactly(QIODevice &device, char *data, qint64 size)
+{
+    qint64 received = 0;
+    while (received < size)
+    {
+        qint64 count = device.read(data + received, size - received);
+        if (count < 0)
+            return false;
+        received += count;
+
+        // Для канала процесса ждем данных, файл stdin читается блокирующе
+        // и возвращает 0 только в конце потока.
+        if (count == 0 && received < size && !device.waitForReadyRead(-1))
+            return false;
+    }
+    return true;
+}
+
+bool readMessage(QIODevice &device, QByteArray &payload)
+{
+    qint64 size = 0;
+    if (!readExactly(device, reinterpret_cast<char *>(&size), sizeof(size)))
+        return false;
+
+    size = qFromLittleEndian(size);
+    if (size < 0)
+        return false;
+
+    payload.resize(size);
+    return readExactly(device, payload.data(), size);
+}
+}
+
+ShardCoordinator::ShardCoordinator(const QStringList &files, int workers)
+{
+    const int count = std::max(1, std::min(workers, static_cast<int>(files.size())));
+    if (files.isEmpty())
+        return;
+
+    // Крупные файлы раздаются первыми, каждый - наименее загруженному исполнителю.
+    QVector<std::pair<qint64, QString>> sized;
+    for (const auto &file : files)
+        sized.append({QFileInfo(file).size(), file});
+    std::stable_sort(sized.begin(), sized.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+    _assignments.resize(count);
+    QVector<qint64> load(count, 0);
+    for (const auto &file : sized)
+    {
+        int worker = std::min_element(load.begin(), load.end()) - load.begin();
+        _assignments[worker].append(file.second);
+        load[worker] += file.first;
+    }
+}
+
+ShardCoordinator::~ShardCoordinator()
+{
+    // Конец stdin завершает цикл исполнителя.
+    for (auto worker : _workers)
+    {
+        worker->closeWriteChannel();
+        if (!worker->waitForFinished())
+            worker->kill();
+        delete worker;
+    }
+}
+
+bool ShardCoordinator::start()
+{
+    for (const auto &files : qAsConst(_assignments))
+    {
+        auto worker = new QProcess();
+        worker->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        worker->start(QCoreApplication::applicationFilePath(), QStringList() << workerKey << files);
+        _workers.append(worker);
+
+        if (!worker->waitForStarted())
+            fail("Failed to start shard worker: " + worker->errorString());
+    }
+    return !_failed;
+}
+
+StatisticsAccumulator ShardCoordinator::pass(const AccumulatorLayout &layout)
+{
+    TRACE_SPAN("ShardCoordinator::pass");
+    for (const auto &cached : qAsConst(_cache))
+    {
+        if (cached.first == layout)
+            return cached.second;
+    }
+
+    StatisticsAccumulator total(layout);
+    if (_failed)
+        return total;
+
+    QByteArray request;
+    QDataStream requestStream(&request, QIODevice::WriteOnly);
+    requestStream << layout;
+
+    // Сначала раздаем проход всем, чтобы исполнители работали одновременно.
+    for (int i = 0; i < _workers.size() && !_failed; i++)
+    {
+        if (!writeMessage(*_workers[i], request))
+            fail(QString("Shard worker %1 did not accept the pass: %2").arg(i).arg(_workers[i]->errorString()));
+    }
+    for (auto worker : qAsConst(_workers))
+    {
+        // Без цикла событий QProcess передает запись только внутри waitFor*.
+        while (worker->bytesToWrite() > 0 && worker->waitForBytesWritten(-1))
+        {
+        }
+    }
+
+    for (int i = 0; i < _workers.size() && !_failed; i++)
+    {
+        QByteArray response;
+        if (!readMessage(*_workers[i], response))
+        {
+            fail(QString("Shard worker %1 stopped without a reply: %2").arg(i).arg(_workers[i]->errorString()));
+            continue;
+        }
+
+        StatisticsAccumulator partial;
+        QDataStream responseStream(response);
+        responseStream >> partial;
+        if (responseStream.status() != QDataStream::Ok)
+            fail(QString("Shard worker %1 sent a malformed reply").arg(i));
+        else if (!(partial.layout() == layout))
+            fail(QString("Shard worker %1 replied for a different accumulator layout").arg(i));
+        else
+            total.merge(partial);
+    }
+
+    if (_failed)
+        return StatisticsAccumulator(layout);
+
+    _cache.append({layout, total});
+    return total;
+}
+
+void ShardCoordinator::fail(const QString &error)
+{
+    // Сообщается только первая ошибка: после нее проходы не выполняются.
+    if (_failed)
+        return;
+
+    qDebug().noquote() << error;
+    _failed = true;
+    _error = error;
+}
+
+bool ShardCoordinator::isWorker(int argc, char *argv[])
+{
+    return argc > 1 && QString(argv[1]) == workerKey;
+}
+
+int ShardCoordinator::runWorker(int argc, char *argv[])
+{
+#if defined(Q_OS_WIN)
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    QStringList files;
+    for (int i = 2; i < argc; i++)
+        files.append(QString::fromLocal8Bit(argv[i]));
+
+    QFile input;
+    QFile output;
+    // Без буфера QFile: буферизованное чтение ждало бы данных сверх запроса.
+    if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Unbuffered)
+        || !output.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered))
+        return 1;
+
+    QByteArray request;
+    while (readMessage(input, request))
+    {
+        AccumulatorLayout layout;
+        QDataStream requestStream(request);
+        requestStream >> layout;
+
+        StatisticsAccumulator total(layout);
+        for (const auto &file : qAsConst(files))
+        {
+            QVector<double> values;
+            if (!SampleFile::read(file, values))
+                return 1;
+            total.add(values.constData(), values.size());
+        }
+
+        QByteArray response;
+        QDataStream responseStream(&response, QIODevice::WriteOnly);
+        responseStream << total;
+        if (!writeMessage(output, response) || !output.flush())
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef SHARDCOORDINATOR_H
+#define SHARDCOORDINATOR_H
+
+#include "statisticsaccumulator.h"
+#include <QStringList>
+#include <QVector>
+
+class QProcess;
+
+/**
+ * @brief Расчет по файлам выборки в нескольких локальных процессах.
+ * @details Файлы делятся между исполнителями по размеру. Исполнитель - эта же
+ * программа с ключом --shard-worker: раскладку прохода он получает через stdin,
+ * читает свои файлы по одному и возвращает сериализованный накопитель через
+ * stdout. Поэтому каждый процесс держит в памяти не больше одного файла.
+ */
+class ShardCoordinator
+{
+public:
+    ShardCoordinator(const QStringList &files, int workers);
+    ~ShardCoordinator();
+
+    ShardCoordinator(const ShardCoordinator &) = delete;
+    ShardCoordinator &operator=(const ShardCoordinator &) = delete;
+
+    /// Запускает исполнителей.
+    bool start();
+
+    /**
+     * Проход по всем файлам: раскладка рассылается исполнителям, их накопители
+     * объединяются по порядку. Результаты повторных проходов берутся из кэша.
+     */
+    StatisticsAccumulator pass(const AccumulatorLayout &layout);
+
+    /// Был ли сбой хотя бы одного исполнителя.
+    bool hasFailed() const { return _failed; }
+
+    /// Описание первого сбоя.
+    QString errorString() const { return _error; }
+
+    /// Запущена ли программа как исполнитель.
+    static bool isWorker(int argc, char *argv[]);
+
+    /// Цикл исполнителя, возвращает код завершения.
+    static int runWorker(int argc, char *argv[]);
+
+private:
+    void fail(const QString &error);
+
+private:
+    QVector<QStringList> _assignments;
+    QVector<QProcess *> _workers;
+    QVector<std::pair<AccumulatorLayout, StatisticsAccumulator>> _cache;
+    bool _failed = false;
+    QString _error;
+};
+
+#endif // SHARDCOORDINATOR_H
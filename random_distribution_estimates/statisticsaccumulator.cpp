@@ -0,0 +1,244 @@
+#include "statisticsaccumulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+int AccumulatorLayout::sketchBin(double value) const
+{
+    const double range = upper - lower;
+    if (range <= 0)
+        return 0;
+    // Ограничение до приведения: при узком диапазоне далекие значения не помещаются в int
+    return static_cast<int>(std::clamp((value - lower) / range * sketchBins, 0.0, sketchBins - 1.0));
+}
+
+bool AccumulatorLayout::operator==(const AccumulatorLayout &other) const
+{
+    return lower == other.lower && upper == other.upper && bins == other.bins
+           && sketchBins == other.sketchBins
+           && windowFirst == other.windowFirst && windowLast == other.windowLast;
+}
+
+StatisticsAccumulator::StatisticsAccumulator(const AccumulatorLayout &layout) :
+    _layout(layout)
+{
+    if (_layout.bins > 0)
+    {
+        const double delta = (_layout.upper - _layout.lower) / _layout.bins;
+        _bounds.resize(_layout.bins);
+        for (int i = 0; i < _layout.bins; i++)
+            _bounds[i] = _layout.lower + (i + 1) * delta;
+        _histogram.fill(0, _layout.bins);
+    }
+
+    if (_layout.sketchBins > 0)
+        _sketch.fill(0, _layout.sketchBins);
+}
+
+void StatisticsAccumulator::add(double value)
+{
+    // Обновление моментов по одному значению (Pébay, 2008).
+    const double n = static_cast<double>(++_count);
+    const double delta = value - _mean;
+    const double deltaN = delta / n;
+    const double deltaN2 = deltaN * deltaN;
+    const double term = delta * deltaN * (n - 1);
+
+    _mean += deltaN;
+    _m4 += term * deltaN2 * (n * n - 3 * n + 3) + 6 * deltaN2 * _m2 - 4 * deltaN * _m3;
+    _m3 += term * deltaN * (n - 2) - 3 * deltaN * _m2;
+    _m2 += term;
+
+    _min = std::min(_min, value);
+    _max = std::max(_max, value);
+    addToLayout(value);
+}
+
+void StatisticsAccumulator::add(const double *values, int count)
+{
+    if (count <= 0)
+        return;
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        sum += values[i];
+        _min = std::min(_min, values[i]);
+        _max = std::max(_max, values[i]);
+    }
+    const double blockMean = sum / count;
+
+    double m2 = 0.0;
+    double m3 = 0.0;
+    double m4 = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        const double d = values[i] - blockMean;
+        const double d2 = d * d;
+        m2 += d2;
+        m3 += d2 * d;
+        m4 += d2 * d2;
+    }
+    mergeMoments(count, blockMean, m2, m3, m4);
+
+    if (_layout.bins > 0 || _layout.sketchBins > 0)
+    {
+        for (int i = 0; i < count; i++)
+            addToLayout(values[i]);
+    }
+}
+
+void StatisticsAccumulator::merge(const StatisticsAccumulator &other)
+{
+    Q_ASSERT(_layout == other._layout);
+
+    mergeMoments(other._count, other._mean, other._m2, other._m3, other._m4);
+    _min = std::min(_min, other._min);
+    _max = std::max(_max, other._max);
+
+    for (int i = 0; i < _histogram.size(); i++)
+        _histogram[i] += other._histogram[i];
+    for (int i = 0; i < _sketch.size(); i++)
+        _sketch[i] += other._sketch[i];
+    _window += other._window;
+}
+
+double StatisticsAccumulator::skewness() const
+{
+    if (_m2 <= 0)
+        return 0.0;
+    return std::sqrt(static_cast<double>(_count)) * _m3 / std::pow(_m2, 1.5);
+}
+
+double StatisticsAccumulator::kurtosis() const
+{
+    if (_m2 <= 0)
+        return 0.0;
+    return static_cast<double>(_count) * _m4 / (_m2 * _m2) - 3.0;
+}
+
+double StatisticsAccumulator::centralMoment(int order) const
+{
+    if (_count == 0)
+        return 0.0;
+
+    switch (order)
+    {
+    case 2: return _m2 / _count;
+    case 3: return _m3 / _count;
+    case 4: return _m4 / _count;
+    default: return 0.0;
+    }
+}
+
+void StatisticsAccumulator::mergeMoments(qint64 count, double mean, double m2, double m3, double m4)
+{
+    if (count == 0)
+        return;
+
+    if (_count == 0)
+    {
+        _count = count;
+        _mean = mean;
+        _m2 = m2;
+        _m3 = m3;
+        _m4 = m4;
+        return;
+    }
+
+    // Объединение центральных сумм двух частей (Chan и др., Pébay).
+    const double na = static_cast<double>(_count);
+    const double nb = static_cast<double>(count);
+    const double n = na + nb;
+    const double delta = mean - _mean;
+    const double delta2 = delta * delta;
+
+    const double newM4 = _m4 + m4
+                         + delta2 * delta2 * na * nb * (na * na - na * nb + nb * nb) / (n * n * n)
+                         + 6 * delta2 * (na * na * m2 + nb * nb * _m2) / (n * n)
+                         + 4 * delta * (na * m3 - nb * _m3) / n;
+    const double newM3 = _m3 + m3
+                         + delta2 * delta * na * nb * (na - nb) / (n * n)
+                         + 3 * delta * (na * m2 - nb * _m2) / n;
+    const double newM2 = _m2 + m2 + delta2 * na * nb / n;
+
+    _count += count;
+    _mean += delta * nb / n;
+    _m2 = newM2;
+    _m3 = newM3;
+    _m4 = newM4;
+}
+
+void StatisticsAccumulator::addToLayout(double value)
+{
+    const int bins = _layout.bins;
+    if (bins > 0)
+    {
+        // Значение относится к первому интервалу, верхняя граница которого не меньше него,
+        // значения выше округленной последней границы - к последнему.
+        const double delta = (_layout.upper - _layout.lower) / bins;
+        int index = delta > 0 ? std::clamp(static_cast<int>((value - _layout.lower) / delta), 0, bins - 1) : 0;
+        while (index > 0 && value <= _bounds[index - 1])
+            index--;
+        while (index < bins - 1 && value > _bounds[index])
+            index++;
+
+        _histogram[index]++;
+    }
+
+    if (_layout.sketchBins > 0)
+    {
+        const int bin = _layout.sketchBin(value);
+        _sketch[bin]++;
+        if (bin >= _layout.windowFirst && bin <= _layout.windowLast)
+            _window.append(value);
+    }
+}
+
+QDataStream &operator<<(QDataStream &stream, const AccumulatorLayout &layout)
+{
+    return stream << layout.lower << layout.upper << layout.bins << layout.sketchBins
+                  << layout.windowFirst << layout.windowLast;
+}
+
+QDataStream &operator>>(QDataStream &stream, AccumulatorLayout &layout)
+{
+    return stream >> layout.lower >> layout.upper >> layout.bins >> layout.sketchBins
+                  >> layout.windowFirst >> layout.windowLast;
+}
+
+QDataStream &operator<<(QDataStream &stream, const StatisticsAccumulator &accumulator)
+{
+    return stream << accumulator._layout << accumulator._count << accumulator._mean
+                  << accumulator._m2 << accumulator._m3 << accumulator._m4
+                  << accumulator._min << accumulator._max
+                  << accumulator._histogram
+                  << accumulator._sketch << accumulator._window;
+}
+
+QDataStream &operator>>(QDataStream &stream, StatisticsAccumulator &accumulator)
+{
+    AccumulatorLayout layout;
+    stream >> layout;
+
+    StatisticsAccumulator result(layout);
+    stream >> result._count >> result._mean >> result._m2 >> result._m3 >> result._m4
+           >> result._min >> result._max >> result._histogram
+           >> result._sketch >> result._window;
+
+    if (result._histogram.size() != std::max(layout.bins, 0) || result._sketch.size() != std::max(layout.sketchBins, 0))
+        stream.setStatus(QDataStream::ReadCorruptData);
+    else
+        accumulator = result;
+    return stream;
+}
+
+StatisticsAccumulator accumulateShard(const SampleShard &shard, const AccumulatorLayout &layout)
+{
+    StatisticsAccumulator accumulator(layout);
+    shard([&accumulator](const double *values, int count)
+    {
+        accumulator.add(values, count);
+    });
+    return accumulator;
+}
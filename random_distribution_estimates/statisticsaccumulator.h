@@ -0,0 +1,110 @@
+#ifndef STATISTICSACCUMULATOR_H
+#define STATISTICSACCUMULATOR_H
+
+#include <QDataStream>
+#include <QVector>
+#include <functional>
+#include <limits>
+
+/**
+ * @brief Что собирает накопитель кроме моментов.
+ * @details Границы гистограммы и эскиза известны только после первого
+ * прохода, поэтому накопители всех участков одного прохода строятся по
+ * одной раскладке, иначе их нельзя объединить.
+ */
+struct AccumulatorLayout
+{
+    double lower = 0.0;         ///< Нижняя граница гистограммы и эскиза
+    double upper = 0.0;         ///< Верхняя граница гистограммы и эскиза
+    int bins = 0;               ///< Интервалы гистограммы, 0 - без гистограммы
+    int sketchBins = 0;         ///< Интервалы квантильного эскиза, 0 - без эскиза
+    int windowFirst = -1;       ///< Первый интервал эскиза, значения которого сохраняются
+    int windowLast = -1;        ///< Последний такой интервал, -1 - без окна
+
+    /// Номер интервала эскиза для значения.
+    int sketchBin(double value) const;
+
+    bool operator==(const AccumulatorLayout &other) const;
+};
+
+/**
+ * @brief Объединяемый накопитель характеристик выборки.
+ * @details Хранит число значений, среднее, центральные суммы M2, M3, M4 и крайние
+ * значения. Накопители участков выборки (файлов, потоков, процессов) объединяются
+ * точно по формулам параллельного счета моментов (Chan, Pébay), результат
+ * совпадает с расчетом по всей выборке с точностью до округления. По раскладке
+ * дополнительно строятся гистограмма, квантильный эскиз и окно значений
+ * для точной медианы. Накопитель сериализуется в QDataStream.
+ */
+class StatisticsAccumulator
+{
+public:
+    StatisticsAccumulator() = default;
+    explicit StatisticsAccumulator(const AccumulatorLayout &layout);
+
+    void add(double value);
+
+    /// Блок учитывается двумя проходами по нему и объединяется с накопленным.
+    void add(const double *values, int count);
+
+    void merge(const StatisticsAccumulator &other);
+
+    const AccumulatorLayout &layout() const { return _layout; }
+
+    qint64 count() const { return _count; }
+    double mean() const { return _mean; }
+    double minimum() const { return _min; }
+    double maximum() const { return _max; }
+
+    /// Несмещенная оценка дисперсии.
+    double dispersion() const { return _count > 1 ? _m2 / (_count - 1.0) : 0.0; }
+    double skewness() const;
+    double kurtosis() const;    ///< Эксцесс
+
+    /// Центральный момент порядка 2, 3 или 4 (деление на число значений).
+    double centralMoment(int order) const;
+
+    /// Гистограмма по правилу CalcUnit::createHistogramSet.
+    const QVector<qint64> &histogram() const { return _histogram; }
+    const QVector<qint64> &sketch() const { return _sketch; }
+
+    /// Значения окна в порядке поступления.
+    const QVector<double> &window() const { return _window; }
+
+    friend QDataStream &operator<<(QDataStream &stream, const StatisticsAccumulator &accumulator);
+    friend QDataStream &operator>>(QDataStream &stream, StatisticsAccumulator &accumulator);
+
+private:
+    void mergeMoments(qint64 count, double mean, double m2, double m3, double m4);
+    void addToLayout(double value);
+
+private:
+    AccumulatorLayout _layout;
+
+    qint64 _count = 0;
+    double _mean = 0.0;
+    double _m2 = 0.0;
+    double _m3 = 0.0;
+    double _m4 = 0.0;
+    double _min = std::numeric_limits<double>::max();
+    double _max = std::numeric_limits<double>::lowest();
+
+    QVector<double> _bounds;        ///< Верхние границы интервалов гистограммы
+    QVector<qint64> _histogram;
+    QVector<qint64> _sketch;
+    QVector<double> _window;
+};
+
+QDataStream &operator<<(QDataStream &stream, const AccumulatorLayout &layout);
+QDataStream &operator>>(QDataStream &stream, AccumulatorLayout &layout);
+
+/**
+ * Участок выборки для распределенного расчета: передает свои значения
+ * блоками в visitor(const double *values, int count) на каждом проходе.
+ */
+using SampleShard = std::function<void(const std::function<void(const double *, int)> &)>;
+
+/// Накопитель одного участка по раскладке.
+StatisticsAccumulator accumulateShard(const SampleShard &shard, const AccumulatorLayout &layout);
+
+#endif // STATISTICSACCUMULATOR_H
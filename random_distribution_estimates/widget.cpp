@@ -1,6 +1,8 @@
 #include "widget.h"
 
+#include "backgroundtask.h"
 #include "chartview.h"
+#include "tracing.h"
 #include "qboxlayout.h"
 #include "qgroupbox.h"
 #include "qvalueaxis.h"
@@ -11,6 +13,7 @@
 #include <QLineSeries>
 #include <QTableWidget>
 #include <QHeaderView>
+#include <QSpinBox>
 
 using namespace QtCharts;
 
@@ -32,21 +35,25 @@ Widget::Widget(QWidget *parent)
     auto layout_rand = new QVBoxLayout(tab_rand);
     auto layout_gist = new QHBoxLayout(tab_rand);
 
-    auto data = _unit.randomData();
     auto group_state = new QGroupBox("Характеристики: ", this);
     auto state_layout = new QVBoxLayout(this);
-    state_layout->addWidget(createStatWidget(data, q2));
+    auto state_placeholder = createPlaceholder();
+    state_layout->addWidget(state_placeholder);
     group_state->setLayout(state_layout);
 
-    layout_gist->addWidget(createWidget(data, q1));
-    layout_gist->addWidget(createWidget(data, q2));
+    auto hist_q1 = createPlaceholder();
+    auto hist_q2 = createPlaceholder();
+    layout_gist->addWidget(hist_q1);
+    layout_gist->addWidget(hist_q2);
     layout_gist->addWidget(group_state);
 
     layout_rand->addLayout(layout_gist);
     tab_rand->setLayout(layout_rand);
     tabWidget->addTab(tab_rand, "Диаграмма распределения");
 
-    tabWidget->addTab(createTableWidget(q2), "Таблица распределения");
+    auto table_q1 = createTable();
+    auto table_q2 = createTable();
+    tabWidget->addTab(createTableWidget(table_q1, table_q2), "Таблица распределения");
 
     wgt_layout->addWidget(tabWidget);
 
@@ -54,9 +61,73 @@ Widget::Widget(QWidget *parent)
 
     setMinimumHeight(800);
     setMinimumWidth(1600);
+
+    // Выборка читается из файла в пуле потоков, панели заполняются по готовности.
+    runInBackground(this, []() { return QSharedPointer<CalcUnit>::create(); },
+                    [this, state_placeholder, hist_q1, hist_q2, table_q1, table_q2](const QSharedPointer<CalcUnit> &unit)
+    {
+        _unit = unit;
+        _data = unit->randomData();
+        calculate(state_placeholder, hist_q1, hist_q2, table_q1, table_q2);
+    });
 }
 
-QWidget *Widget::createTable(int ranges)
+void Widget::calculate(QWidget *statePlaceholder, QWidget *histQ1, QWidget *histQ2,
+                       QTableWidget *tableQ1, QTableWidget *tableQ2)
+{
+    // Оценка плотности строится один раз: по ней и мода в характеристиках,
+    // и кривая распределения на гистограммах.
+    auto unit = _unit;
+    auto data = _data;
+    runInBackground(this, [data]() { return QSharedPointer<KernelDensity>::create(data); },
+                    [this, unit, data, statePlaceholder, histQ1, histQ2, tableQ1, tableQ2](const QSharedPointer<KernelDensity> &density)
+    {
+        // Характеристики показываются сразу по готовности, бутстреп-интервал
+        // дописывается в панель позже, когда закончится ресемплинг.
+        runInBackground(this, [unit, data, density, ranges = q2]() { return unit->calculateStatistics(data, ranges, *density); },
+                        [this, unit, data, statePlaceholder](const Statistics &stats)
+        {
+            auto stat_widget = createStatWidget(stats);
+            replacePlaceholder(statePlaceholder, stat_widget);
+
+            auto bootstrap_label = stat_widget->findChild<QLabel *>("bootstrap");
+            runInBackground(bootstrap_label, [unit, data]() { return unit->bootstrapIntervals(data); },
+                            [this, bootstrap_label](const BootstrapResult &bootstrap)
+            {
+                bootstrap_label->setText(bootstrapString(bootstrap));
+            });
+        });
+
+        // Выборка сортируется один раз, дальше гистограммы и таблицы на любое
+        // число интервалов строятся по ней без просмотра данных.
+        runInBackground(this, [data, density]()
+        {
+            return HistogramView{QSharedPointer<BinnedSample>::create(data),
+                                 QSharedPointer<HistogramPyramid>::create(data),
+                                 density};
+        },
+        [this, histQ1, histQ2, tableQ1, tableQ2](const HistogramView &view)
+        {
+            replacePlaceholder(histQ1, createWidget(view, q1, tableQ1));
+            replacePlaceholder(histQ2, createWidget(view, q2, tableQ2));
+        });
+    });
+}
+
+QWidget *Widget::createPlaceholder()
+{
+    auto placeholder = new QLabel("Вычисление...", this);
+    placeholder->setAlignment(Qt::AlignCenter);
+    return placeholder;
+}
+
+void Widget::replacePlaceholder(QWidget *placeholder, QWidget *widget)
+{
+    delete placeholder->parentWidget()->layout()->replaceWidget(placeholder, widget);
+    placeholder->deleteLater();
+}
+
+QTableWidget *Widget::createTable()
 {
     auto tableWidget = new QTableWidget(this);
     tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -79,7 +150,13 @@ QWidget *Widget::createTable(int ranges)
                                                          << "Отклонение \n (nₓ - N∙pⱼ)²"
                                                          << "Итоговая оценка \n((nₓ - N∙pⱼ)²) / (N∙pⱼ)");
 
-    auto stats = _unit.getHistogramAnalysis(_unit.randomData(), ranges);
+    return tableWidget;
+}
+
+void Widget::fillTable(QTableWidget *tableWidget, const HistInfo &stats, int ranges)
+{
+    TRACE_SPAN("Widget::fillTable");
+    tableWidget->setRowCount(0);
     for (int i = 0; i < ranges; i++)
     {
         int row = tableWidget->rowCount();
@@ -112,13 +189,12 @@ QWidget *Widget::createTable(int ranges)
     addCenteredItem(QString("x² = ") + getDoubleString(totalResult), tableWidget, row, 9);
     addCenteredItem(QString("Xкрит = ") + getDoubleString(stats.x_crit), tableWidget, row, 8);
 
-    return tableWidget;
+    if (auto group = qobject_cast<QGroupBox *>(tableWidget->parentWidget()))
+        group->setTitle(QString("Оценка выборки на %1 диапазонов").arg(ranges));
 }
 
-QWidget *Widget::createTableWidget(int ranges)
+QWidget *Widget::createTableWidget(QTableWidget *table_q1, QTableWidget *table_q2)
 {
-    QVector<double> data;
-    data = _unit.randomData();
     QString namePattern = QString("Оценка выборки на %1 диапазонов");
 
     auto wgt = new QWidget(this);
@@ -130,8 +206,8 @@ QWidget *Widget::createTableWidget(int ranges)
     auto q1_layout = new QHBoxLayout(this);
     auto q2_layout = new QVBoxLayout(this);
 
-    q1_layout->addWidget(createTable(q1));
-    q2_layout->addWidget(createTable(q2));
+    q1_layout->addWidget(table_q1);
+    q2_layout->addWidget(table_q2);
 
     group_q1->setLayout(q1_layout);
     group_q2->setLayout(q2_layout);
@@ -144,8 +220,9 @@ QWidget *Widget::createTableWidget(int ranges)
     return wgt;
 }
 
-QWidget *Widget::createWidget(const QVector<double> &data, int ranges)
+QWidget *Widget::createWidget(const HistogramView &view, int ranges, QTableWidget *table)
 {
+    TRACE_SPAN("Widget::createWidget");
     auto wgt = new QWidget(this);
     auto wgt_layout = new QHBoxLayout(this);
 
@@ -153,7 +230,37 @@ QWidget *Widget::createWidget(const QVector<double> &data, int ranges)
     auto graph_layout = new QHBoxLayout(this);
 
     auto name = QString("Выборка: %1 на %2 диапазонов");
-    graph_layout->addWidget(createView(name.arg(data.size()).arg(ranges), data, ranges));
+    auto chart_view = createView(name.arg(view.sample->size()).arg(ranges), view, ranges);
+    graph_layout->addWidget(chart_view);
+
+    auto controls_layout = new QVBoxLayout();
+    auto ranges_box = new QSpinBox(this);
+    ranges_box->setRange(minRanges, maxRanges);
+    ranges_box->setValue(ranges);
+    ranges_box->setPrefix("Интервалов: ");
+    controls_layout->addWidget(ranges_box);
+
+    // Мода своя у каждой гистограммы: панель характеристик считается по q2 интервалам.
+    auto mode_label = new QLabel("Мода: \n" + QString::number(view.sample->mode(ranges)), this);
+    mode_label->setAlignment(Qt::AlignCenter);
+    controls_layout->addWidget(mode_label);
+    controls_layout->addStretch();
+    graph_layout->addLayout(controls_layout);
+
+    fillTable(table, _unit->getHistogramAnalysis(*view.sample, ranges), ranges);
+
+    // Гистограмма, мода и таблица x² пересчитываются по отсортированной
+    // выборке двоичным поиском границ интервалов.
+    auto unit = _unit;
+    auto sample = view.sample;
+    connect(ranges_box, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            [this, chart_view, table, mode_label, unit, sample, name](int bins)
+    {
+        chart_view->setBaseHistogram(sample->histogram(bins));
+        chart_view->chart()->setTitle(name.arg(sample->size()).arg(bins));
+        fillTable(table, unit->getHistogramAnalysis(*sample, bins), bins);
+        mode_label->setText("Мода: \n" + QString::number(sample->mode(bins)));
+    });
 
     group_graph->setLayout(graph_layout);
     wgt_layout->addWidget(group_graph);
@@ -162,11 +269,12 @@ QWidget *Widget::createWidget(const QVector<double> &data, int ranges)
     return wgt;
 }
 
-QChartView * Widget::createView(const QString & name, const QVector<double> &data, int histCount)
+ChartView * Widget::createView(const QString & name, const HistogramView &view, int histCount)
 {
+    TRACE_SPAN("Widget::createView");
     auto set = new QBarSet("Гистограмма");
 
-    auto  hist = _unit.createHistogramSet(data, histCount);
+    auto hist = view.sample->histogram(histCount);
 
     for (int i = 0; i < histCount; ++i)
         *set << hist[i];
@@ -178,8 +286,6 @@ QChartView * Widget::createView(const QString & name, const QVector<double> &dat
     auto lineSeries = new QLineSeries();
     lineSeries->setPen(QPen(Qt::red));
     lineSeries->setName("Кривая распределения");
-    for (int i = 0; i < histCount; ++i)
-        lineSeries->append(i, hist[i]);
 
     auto chart = new QChart();
     chart->addSeries(series);
@@ -197,8 +303,7 @@ QChartView * Widget::createView(const QString & name, const QVector<double> &dat
     lineSeries->attachAxis(axisX);
 
     auto axisXData = new QValueAxis();
-    auto min_max= std::minmax_element(data.begin(), data.end());
-    axisXData->setRange(*min_max.first, *min_max.second);
+    axisXData->setRange(view.pyramid->minimum(), view.pyramid->maximum());
     axisXData->setTickCount(histCount + 1);
     chart->addAxis(axisXData, Qt::AlignBottom);
 
@@ -211,21 +316,22 @@ QChartView * Widget::createView(const QString & name, const QVector<double> &dat
     chart_view->setRenderHint(QPainter::Antialiasing);
     chart_view->setRubberBand(QChartView::RectangleRubberBand);
     chart_view->setInteractive(true);
+    chart_view->setHistogram(view.pyramid, set, axisX, axisXData, lineSeries, view.density);
 
     return chart_view;
 }
 
-QWidget *Widget::createStatWidget(const QVector<double> &data, int size)
+QWidget *Widget::createStatWidget(const Statistics &stats)
 {
+    TRACE_SPAN("Widget::createStatWidget");
     auto stat_widget = new QWidget(this);
     auto stat_layout = new QVBoxLayout(stat_widget);
 
-    auto stats = _unit.calculateStatistics(data, size);
-
     addCenteredLabel("Математическое \nожидание: \n", stats.expectedValue, stat_widget, stat_layout);
     addCenteredLabel("Дисперсия: \n", stats.dispersion, stat_widget, stat_layout);
     addCenteredLabel("Медиана: \n", stats.median, stat_widget, stat_layout);
     addCenteredLabel("Мода: \n", stats.modeValue, stat_widget, stat_layout);
+    addCenteredLabel("Мода по оценке \nплотности: \n", stats.densityMode, stat_widget, stat_layout);
     addCenteredLabel("Среднее \nквадратическое  \nотклонение: \n", stats.standardDeviation, stat_widget, stat_layout);
     addCenteredLabel("Коэффициент \nассиметрии: \n", stats.skewness, stat_widget, stat_layout);
     addCenteredLabel("Эксцесс: \n", stats.kurtosis, stat_widget, stat_layout);
@@ -243,12 +349,26 @@ QWidget *Widget::createStatWidget(const QVector<double> &data, int size)
     interval_label->setFont(font);
 
     stat_layout->addWidget(interval_label);
+
+    auto bootstrap_label = new QLabel("Бутстреп-интервал \n(BCa): \n вычисление...", stat_widget);
+    bootstrap_label->setObjectName("bootstrap");
+    bootstrap_label->setAlignment(Qt::AlignCenter);
+    bootstrap_label->setFont(font);
+
+    stat_layout->addWidget(bootstrap_label);
     stat_widget->setLayout(stat_layout);
 
     return stat_widget;
 }
 
-void Widget::addCenteredLabel(const QString &text, double value, QWidget *parent, QLayout * layout)
+QString Widget::bootstrapString(const BootstrapResult &bootstrap) const
+{
+    return QString("Бутстреп-интервал \n(BCa): \n [") +
+           QString::number(bootstrap.expectedValue.bca.first) + " : "
+           + QString::number(bootstrap.expectedValue.bca.second) + "]";
+}
+
+QLabel *Widget::addCenteredLabel(const QString &text, double value, QWidget *parent, QLayout * layout)
 {
     auto label = new QLabel(text + QString::number(value), parent);
     label->setAlignment(Qt::AlignCenter);
@@ -258,6 +378,7 @@ void Widget::addCenteredLabel(const QString &text, double value, QWidget *parent
     label->setFont(font);
 
     layout->addWidget(label);
+    return label;
 }
 
 void Widget::addCenteredItem(const QString &text, QTableWidget *widget, int row, int column)
@@ -2,33 +2,58 @@
 #define WIDGET_H
 
 #include <QWidget>
+#include <QSharedPointer>
 #include "calcunit.h"
+#include "binnedsample.h"
+#include "histogrampyramid.h"
+#include "kerneldensity.h"
 
 class QLabel;
 class QTableWidget;
+class ChartView;
 
 namespace QtCharts { class QChartView; class QLineSeries; class QChart; class QValueAxis;}
 
+struct HistogramView
+{
+    QSharedPointer<BinnedSample> sample;        ///< Выборка для смены числа интервалов
+    QSharedPointer<HistogramPyramid> pyramid;   ///< Гистограмма для масштабирования
+    QSharedPointer<KernelDensity> density;      ///< Оценка плотности для кривой распределения
+};
+
 class Widget : public QWidget {
     Q_OBJECT
 
 public:
     explicit Widget(QWidget *parent = nullptr);
 
-    QWidget * createWidget(const QVector<double> &data, int ranges);
-    QWidget *createTable(int ranges);
+    static constexpr int minRanges = 4;     ///< Наименьшее число интервалов (x² требует не менее одной степени свободы)
+    static constexpr int maxRanges = 100;   ///< Наибольшее число интервалов гистограммы
+
+    QWidget * createWidget(const HistogramView &view, int ranges, QTableWidget *table);
+    QTableWidget *createTable();
+    void fillTable(QTableWidget *tableWidget, const HistInfo &stats, int ranges);
 
-    QtCharts::QChartView * createView(const QString & name,
-                                     const QVector<double> &data,
+    ChartView * createView(const QString & name,
+                                     const HistogramView &view,
                                      int histCount);
 
-    QWidget * createStatWidget(const QVector<double> &data, int size);
-    QWidget *createTableWidget(int ranges);
-    void addCenteredLabel(const QString &text, double value, QWidget *parent, QLayout *layout);
+    QWidget * createStatWidget(const Statistics &stats);
+    QWidget *createTableWidget(QTableWidget *table_q1, QTableWidget *table_q2);
+    QLabel *addCenteredLabel(const QString &text, double value, QWidget *parent, QLayout *layout);
     void addCenteredItem(const QString &text, QTableWidget *widget, int row, int column);
 
 private:
-    CalcUnit _unit;
+    /// Расчеты по прочитанной выборке, результаты заменяют заглушки панелей.
+    void calculate(QWidget *statePlaceholder, QWidget *histQ1, QWidget *histQ2,
+                   QTableWidget *tableQ1, QTableWidget *tableQ2);
+    QWidget *createPlaceholder();
+    void replacePlaceholder(QWidget *placeholder, QWidget *widget);
+    QString bootstrapString(const BootstrapResult &bootstrap) const;
+
+private:
+    QSharedPointer<CalcUnit> _unit;
+    QVector<double> _data;
 
     int q1 = 5;
     int q2 = 7;
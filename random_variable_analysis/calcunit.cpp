@@ -1,8 +1,16 @@
 #include "calcunit.h"
+#include "estimatoraccumulator.h"
+#include "rollingstatistics.h"
+#include "samplefile.h"
+#include "tracing.h"
 
 #include <cmath>
 #include <random>
 #include <algorithm>
+#include <numeric>
+#include <array>
+#include <atomic>
+#include <thread>
 #include <QHash>
 #include <QtMath>
 #include <QFile>
@@ -18,9 +26,47 @@ double normilize(double value, int decimal)
     return std::round(value * scale) / scale;
 }
 
-CalcUnit::CalcUnit(int variantNumber) :
-    _variantNumber(variantNumber)
+template <typename Generator>
+void fillNoise(Generator &gen, bool isGauss, double scale, double *result, int size)
 {
+    std::uniform_real_distribution<double> dis(0.0, 1.0);
+
+    if (!isGauss)
+    {
+        const double variableA = -scale;
+        const double variableB = scale;
+
+        for (int i = 0; i < size; i++)
+        {
+            double value = variableA + dis(gen) * (variableB - variableA);
+            result[i] = normilize(value, 5);
+        }
+        return;
+    }
+
+    const double sko = scale;
+    const double Mo = 0.0;
+
+    for (int i = 0; i < size; i++)
+    {
+        double r1 = dis(gen);
+        double r2 = dis(gen);
+
+        double z = std::sqrt(-2.0 * std::log(r1)) * std::cos(2.0 * M_PI * r2);
+        double value = Mo + (z * (sko));
+        result[i] = normilize(value, 5);
+    }
+}
+
+CalcUnit::CalcUnit(int variantNumber, bool virtualData) :
+    _variantNumber(variantNumber),
+    _virtualData(virtualData)
+{
+    TRACE_SPAN("CalcUnit::CalcUnit");
+    // Виртуальные ряды не хранятся, uniformElements и gaussElements порождают их при каждом запросе.
+    if (_virtualData)
+        return;
+
     QString dataFilePrefix = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     const QString separator = "_";
 
@@ -72,76 +118,85 @@ CalcUnit::CalcUnit(int variantNumber) :
 
 QVector<double> CalcUnit::readDataFromFile(const QString& filePath)
 {
+    TRACE_SPAN("CalcUnit::readDataFromFile");
     QVector<double> data;
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        qDebug() << "Failed to open file for reading:" << filePath;
-        return data;
-    }
-
-    QTextStream in(&file);
-
-    while (!in.atEnd())
-    {
-        auto line = in.readLine();
-        bool ok;
-        double value = line.toDouble(&ok);
-        if (ok)
-            data.append(value);
-        else
-        {
-            qDebug() << "Failed to convert line to double:" << line;
-            return QVector<double>();
-        }
-    }
-
-    file.close();
+    SampleFile::read(filePath, data);
     return data;
 }
 
 void CalcUnit::writeDataToFile(const QString& filePath, const QVector<double>& data)
 {
+    TRACE_SPAN("CalcUnit::writeDataToFile");
     QDir().mkpath(QFileInfo(filePath).absolutePath());
+    SampleFile::write(filePath, data);
+}
+
+int CalcUnit::trimCount(int size)
+{
+    int k = 3;
+    if (size < 10)
+        k = 1;
+    else if (size <= 15)
+        k = 2;
+    return k;
+}
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+LocationEstimates CalcUnit::locationEstimates(QVector<double> &buffer, int trim)
+{
+    Q_ASSERT(trim >= 0 && 2 * trim < buffer.size());
+
+    double sum = 0.0;
+    double minValue = buffer.first();
+    double maxValue = buffer.first();
+    for (const auto &value : qAsConst(buffer))
     {
-        qDebug() << "Failed to open file for writing:" << filePath << file.errorString();
-        return;
+        sum += value;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
     }
 
-    QTextStream out(&file);
-    for (const auto& value : qAsConst(data))
-        out << QString::number(value) << "\n";
+    // k наименьших элементов переносятся в начало, k наибольших - в конец,
+    // усеченное среднее суммирует только середину без вычитания крайних.
+    const int size = buffer.size();
+    if (trim > 0)
+    {
+        std::nth_element(buffer.begin(), buffer.begin() + trim, buffer.end());
+        std::nth_element(buffer.begin() + trim, buffer.begin() + (size - trim), buffer.end());
+    }
+    const double trimmedSum = std::accumulate(buffer.begin() + trim, buffer.begin() + (size - trim), 0.0);
+
+    LocationEstimates result;
+    result.expectedValue = sum / size;
+    result.halfSum = (minValue + maxValue) / 2;
+    result.average = trimmedSum / (size - 2 * trim);
+
+    int middle = size / 2;
+    std::nth_element(buffer.begin(), buffer.begin() + middle, buffer.end());
+    double upper = buffer[middle];
 
-    file.close();
+    result.median = size % 2 == 0
+                    ? (*std::max_element(buffer.begin(), buffer.begin() + middle) + upper) / 2.0
+                    : upper;
+
+    return result;
 }
 
-Statistics CalcUnit::calculateStatistics(const QVector<double> &data)
+Statistics CalcUnit::calculateStatistics(const QVector<double> &data) const
 {
+    TRACE_SPAN("CalcUnit::calculateStatistics");
     Statistics result;
 
-    int k = 3;
-    if (data.size() < 10)
-        k = 1;
-    else if (data.size() <= 15)
-        k = 2;
-
+    int k = trimCount(data.size());
     if (data.isEmpty() || k >= data.size() / 2)
         return result;
 
     QVector<double> sortedData = data;
-    std::sort(sortedData.begin(), sortedData.end());
+    auto estimates = locationEstimates(sortedData, k);
 
-    result.expectedValue = std::accumulate(data.begin(), data.end(), 0.0) / data.size();
-    result.halfSum = (sortedData.first() + sortedData.last()) / 2;
-
-    result.median = sortedData.size() % 2 == 0
-                    ? (sortedData[sortedData.size() / 2 - 1] + sortedData[sortedData.size() / 2]) / 2.0
-                    : sortedData[sortedData.size() / 2];
-
-    result.average = std::accumulate(sortedData.begin() + k, sortedData.end() - k, 0.0) / (sortedData.size() - 2 * k);
+    result.expectedValue = estimates.expectedValue;
+    result.halfSum = estimates.halfSum;
+    result.median = estimates.median;
+    result.average = estimates.average;
 
     result.dispersion = 0.0;
     for (const auto & value : qAsConst(data))
@@ -150,6 +205,44 @@ Statistics CalcUnit::calculateStatistics(const QVector<double> &data)
     result.dispersion = result.dispersion * (1.0 / (data.size() - 1.0));
     result.standardDeviation = std::sqrt(result.dispersion);
 
+    finalizeStatistics(result);
+    return result;
+}
+
+QVector<Statistics> CalcUnit::rollingStatistics(const QVector<double> &series, int window)
+{
+    TRACE_SPAN("CalcUnit::rollingStatistics");
+    QVector<Statistics> result;
+    if (window <= 0 || series.size() < window || trimCount(window) >= window / 2)
+        return result;
+
+    result.reserve(series.size() - window + 1);
+
+    RollingStatistics rolling(window);
+    for (const auto &value : series)
+    {
+        rolling.push(value);
+        if (!rolling.isFull())
+            continue;
+
+        auto estimates = rolling.locationEstimates();
+
+        Statistics statistics;
+        statistics.expectedValue = estimates.expectedValue;
+        statistics.halfSum = estimates.halfSum;
+        statistics.median = estimates.median;
+        statistics.average = estimates.average;
+        statistics.dispersion = rolling.dispersion();
+        statistics.standardDeviation = rolling.standardDeviation();
+
+        finalizeStatistics(statistics);
+        result.append(statistics);
+    }
+    return result;
+}
+
+void CalcUnit::finalizeStatistics(Statistics &result) const
+{
     result.expectedValue = normilize(result.expectedValue, 5);
     result.halfSum = normilize(result.halfSum, 5);
     result.median = normilize(result.median, 5);
@@ -166,12 +259,11 @@ Statistics CalcUnit::calculateStatistics(const QVector<double> &data)
     result.halfSumDelta = normilize(result.halfSumDelta, 5);
     result.medianDelta = normilize(result.medianDelta, 5);
     result.averageDelta = normilize(result.averageDelta, 5);
-
-    return result;
 }
 
 QVector<int> CalcUnit::createHistogramSet(const QVector<double>& data, int size)
 {
+    TRACE_SPAN("CalcUnit::createHistogramSet");
     auto min_max = std::minmax_element(data.begin(), data.end());
 
     double range = min_max.second - min_max.first;
@@ -195,32 +287,37 @@ QVector<int> CalcUnit::createHistogramSet(const QVector<double>& data, int size)
     return hist;
 }
 
-QVector<double> CalcUnit::uniformElements(int size, double coeff)
+QVector<double> CalcUnit::uniformElements(int size, double coeff) const
 {
+    if (_virtualData)
+        return virtualSeries(false, coeff, size).slice(0, size);
     return _uniformSeries.value({size, coeff});
 }
 
-QVector<double> CalcUnit::gaussElements(int size, double coeff)
+QVector<double> CalcUnit::gaussElements(int size, double coeff) const
 {
+    if (_virtualData)
+        return virtualSeries(true, coeff, size).slice(0, size);
     return _gaussSeries.value({size, coeff});
 }
 
-QVector<double> CalcUnit::generateUniformRandomForm(double coef, int size)
+VirtualDataset CalcUnit::virtualSeries(bool isGauss, double coeff, qint64 size) const
 {
-    const double variableA = -_variantNumber / coef;
-    const double variableB = _variantNumber / coef;
+    const double scale = _variantNumber / coeff;
+    quint64 seed = static_cast<quint64>(coeff) << 48 ^ static_cast<quint64>(size) << 1 ^ (isGauss ? 1u : 0u);
 
+    if (isGauss)
+        return VirtualDataset(VirtualDataset::Gauss, 0.0, scale, seed, size, _variantNumber);
+    return VirtualDataset(VirtualDataset::Uniform, -scale, scale, seed, size, _variantNumber);
+}
+
+QVector<double> CalcUnit::generateUniformRandomForm(double coef, int size)
+{
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis(0.0, 1.0);
 
     QVector<double> result(size);
-    for (int i = 0; i < size; i++)
-    {
-        double value = variableA + dis(gen) * (variableB - variableA);
-        result[i] = normilize(value, 5);
-    }
-
+    fillNoise(gen, false, _variantNumber / coef, result.data(), size);
     return result;
 }
 
@@ -228,22 +325,84 @@ QVector<double> CalcUnit::generateGaussRandomForm(double coef, int size)
 {
     std::random_device rd;
     std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> dis(0.0, 1.0);
-
-    const double sko = _variantNumber / coef;
-    const double Mo = 0.0;
 
     QVector<double> result(size);
-    for (int i = 0; i < size; i++)
+    fillNoise(gen, true, _variantNumber / coef, result.data(), size);
+    return result;
+}
+
+EfficiencyStudy CalcUnit::estimatorEfficiency(bool isGauss, double coeff, int size,
+                                              int replications, quint64 seed, int threads)
+{
+    TRACE_SPAN("CalcUnit::estimatorEfficiency");
+    EfficiencyStudy result;
+    int k = trimCount(size);
+    if (size <= 0 || k >= size / 2 || replications <= 0)
+        return result;
+
+    const int blockSize = 256;
+    const int blocks = (replications + blockSize - 1) / blockSize;
+    const double scale = _variantNumber / coeff;
+
+    // Накопители по блокам: итог не зависит от числа потоков
+    std::vector<std::array<EstimatorAccumulator, 4>> partial(blocks);
+    std::atomic<int> nextBlock(0);
+
+    auto worker = [&]()
     {
-        double r1 = dis(gen);
-        double r2 = dis(gen);
+        QVector<double> buffer(size);
+        for (int block = nextBlock++; block < blocks; block = nextBlock++)
+        {
+            std::seed_seq seq{static_cast<quint32>(seed), static_cast<quint32>(seed >> 32),
+                              static_cast<quint32>(block)};
+            std::mt19937_64 gen(seq);
 
-        double z = std::sqrt(-2.0 * std::log(r1)) * std::cos(2.0 * M_PI * r2);
-        double value = Mo + (z * (sko));
-        result[i] = normilize(value, 5);
-    }
+            auto &accumulators = partial[block];
+            int end = std::min(replications, (block + 1) * blockSize);
+            for (int r = block * blockSize; r < end; r++)
+            {
+                fillNoise(gen, isGauss, scale, buffer.data(), size);
+                for (auto &value : buffer)
+                    value += _variantNumber;
+
+                auto estimates = locationEstimates(buffer, k);
+                accumulators[0].add(estimates.expectedValue);
+                accumulators[1].add(estimates.halfSum);
+                accumulators[2].add(estimates.median);
+                accumulators[3].add(estimates.average);
+            }
+        }
+    };
+
+    int count = threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency());
+    count = std::max(1, std::min(count, blocks));
 
+    std::vector<std::thread> pool;
+    for (int i = 1; i < count; i++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+        thread.join();
+
+    std::array<EstimatorAccumulator, 4> total;
+    for (const auto &accumulators : partial)
+        for (int i = 0; i < 4; i++)
+            total[i].merge(accumulators[i]);
+
+    auto efficiency = [this](const EstimatorAccumulator &accumulator)
+    {
+        EstimatorEfficiency value;
+        value.bias = accumulator.mean() - _variantNumber;
+        value.variance = accumulator.variance();
+        value.mse = accumulator.mse(_variantNumber);
+        return value;
+    };
+
+    result.replications = replications;
+    result.expectedValue = efficiency(total[0]);
+    result.halfSum = efficiency(total[1]);
+    result.median = efficiency(total[2]);
+    result.average = efficiency(total[3]);
     return result;
 }
 
@@ -3,6 +3,7 @@
 
 #include <QVector>
 #include <QHash>
+#include "virtualdataset.h"
 
 struct Statistics
 {
@@ -21,16 +22,68 @@ struct Statistics
     double standardDeviation = 0.0;   ///< Среднеквадратичное отклонение
 };
 
+struct LocationEstimates
+{
+    double expectedValue = 0.0;       ///< Математическое ожидание
+    double halfSum = 0.0;             ///< Полусумма крайних членов
+    double median = 0.0;              ///< Медиана
+    double average = 0.0;             ///< Среднее арифметическое с отбросом крайних членов
+};
+
+struct EstimatorEfficiency
+{
+    double bias = 0.0;                ///< Смещение оценки
+    double variance = 0.0;            ///< Дисперсия оценки
+    double mse = 0.0;                 ///< Среднеквадратичная ошибка оценки
+};
+
+struct EfficiencyStudy
+{
+    int replications = 0;             ///< Количество повторений
+
+    EstimatorEfficiency expectedValue;  ///< Математическое ожидание
+    EstimatorEfficiency halfSum;        ///< Полусумма крайних членов
+    EstimatorEfficiency median;         ///< Медиана
+    EstimatorEfficiency average;        ///< Среднее арифметическое с отбросом крайних членов
+};
+
 class CalcUnit
 {
 public:
-    CalcUnit(int variantNumber = 15);
+    /**
+     * @param virtualData Порождать ряды по запросу (VirtualDataset) вместо
+     * чтения и записи файлов в AppDataLocation.
+     */
+    CalcUnit(int variantNumber = 15, bool virtualData = false);
 
-    Statistics calculateStatistics(const QVector<double>& data);
+    Statistics calculateStatistics(const QVector<double>& data) const;
+    /// Характеристики по скользящему окну, по одному результату на каждый отсчет после заполнения окна.
+    QVector<Statistics> rollingStatistics(const QVector<double>& series, int window);
     QVector<int> createHistogramSet(const QVector<double>& data, int size);
 
-    QVector<double> uniformElements(int size, double coeff);
-    QVector<double> gaussElements(int size, double coeff);
+    /**
+     * Ряд заданного размера. Для виртуальных рядов порождается заново при каждом
+     * вызове и не хранится: медиане и усеченному среднему нужна вся выборка в памяти.
+     */
+    QVector<double> uniformElements(int size, double coeff) const;
+    QVector<double> gaussElements(int size, double coeff) const;
+
+    /**
+     * Ряд «значение варианта + шум» произвольного размера, порождаемый
+     * по запросу. Начальное значение определяется законом, коэффициентом и размером.
+     */
+    VirtualDataset virtualSeries(bool isGauss, double coeff, qint64 size) const;
+
+    EfficiencyStudy estimatorEfficiency(bool isGauss, double coeff, int size,
+                                        int replications, quint64 seed = 0, int threads = 0);
+
+    static int trimCount(int size);
+    /**
+     * Оценки положения за O(n): один проход для суммы и крайних членов,
+     * k наименьших/наибольших элементов и медиана через nth_element.
+     * Порядок элементов buffer изменяется.
+     */
+    static LocationEstimates locationEstimates(QVector<double> &buffer, int trim);
 
 private:
     QVector<double> generateUniformRandomForm(double coef, int size);
@@ -39,6 +92,7 @@ private:
     QVector<double> makeParametersSeries(const QVector<double>& noise);
 
     double calculateMode(const QVector<double>& data, int size);
+    void finalizeStatistics(Statistics &result) const;
 
     void writeDataToFile(const QString &fileName, const QVector<double> &data);
     QVector<double> readDataFromFile(const QString &fileName);
@@ -48,6 +102,7 @@ private:
     QHash<std::pair<int /*size*/, double /*coef*/>, QVector<double> /*data*/> _uniformSeries;
 
     int _variantNumber;
+    bool _virtualData;
 };
 
 #endif // CALCUNIT_H
@@ -0,0 +1,56 @@
+#ifndef ESTIMATORACCUMULATOR_H
+#define ESTIMATORACCUMULATOR_H
+
+/**
+ * @brief Накопитель среднего и дисперсии значений оценки.
+ * @details Значения добавляются по Уэлфорду, накопители разных потоков
+ * объединяются точно по формулам Чана, поэтому порядок объединения
+ * не влияет на результат сверх ошибок округления.
+ */
+class EstimatorAccumulator
+{
+public:
+    void add(double value)
+    {
+        _count++;
+        double delta = value - _mean;
+        _mean += delta / _count;
+        _m2 += delta * (value - _mean);
+    }
+
+    void merge(const EstimatorAccumulator &other)
+    {
+        if (other._count == 0)
+            return;
+
+        if (_count == 0)
+        {
+            *this = other;
+            return;
+        }
+
+        long long count = _count + other._count;
+        double delta = other._mean - _mean;
+        _mean += delta * other._count / count;
+        _m2 += other._m2 + delta * delta * _count * other._count / count;
+        _count = count;
+    }
+
+    long long count() const { return _count; }
+    double mean() const { return _mean; }
+    double variance() const { return _count > 1 ? _m2 / (_count - 1) : 0.0; }
+
+    /// Среднеквадратичная ошибка относительно истинного значения.
+    double mse(double trueValue) const
+    {
+        double bias = _mean - trueValue;
+        return _count > 0 ? _m2 / _count + bias * bias : 0.0;
+    }
+
+private:
+    long long _count = 0;
+    double _mean = 0.0;
+    double _m2 = 0.0;
+};
+
+#endif // ESTIMATORACCUMULATOR_H
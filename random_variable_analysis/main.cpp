@@ -1,11 +1,102 @@
 #include "widget.h"
+#include "calcunit.h"
+#include "tracing.h"
+#include "allocationpanel.h"
+#include "samplefile.h"
 
 #include <QApplication>
+#include <QTextStream>
+
+namespace
+{
+int runEfficiencyStudy(int replications)
+{
+    CalcUnit unit;
+    QTextStream out(stdout);
+
+    out << "noise\tcoef\tsize\testimator\tbias\tvariance\tmse\n";
+    for (bool isGauss : {true, false})
+    {
+        for (int coef : {20, 100})
+        {
+            for (int size : {15, 30, 100, 1000})
+            {
+                auto study = unit.estimatorEfficiency(isGauss, coef, size, replications);
+                QVector<std::pair<QString, EstimatorEfficiency>> rows = {
+                    {"mean", study.expectedValue},
+                    {"halfSum", study.halfSum},
+                    {"median", study.median},
+                    {"average", study.average}
+                };
+
+                for (const auto &row : qAsConst(rows))
+                {
+                    out << (isGauss ? "gauss" : "uniform") << '\t' << coef << '\t' << size << '\t'
+                        << row.first << '\t' << row.second.bias << '\t'
+                        << row.second.variance << '\t' << row.second.mse << '\n';
+                }
+            }
+        }
+    }
+
+    if (AllocationStats::isEnabled())
+        out << '\n' << AllocationStats::formatReport();
+    return 0;
+}
+
+int runRollingStatistics(int window, const QString &filePath)
+{
+    QVector<double> series;
+    if (!SampleFile::read(filePath, series))
+        return 1;
+
+    CalcUnit unit;
+    QTextStream out(stdout);
+
+    // Строка на каждое положение окна, first - номер первого отсчета окна
+    out << "first\tmean\thalfSum\tmedian\taverage\tdispersion\n";
+    const auto rows = unit.rollingStatistics(series, window);
+    for (int i = 0; i < rows.size(); i++)
+    {
+        const auto &row = rows[i];
+        out << i << '\t' << row.expectedValue << '\t' << row.halfSum << '\t' << row.median << '\t'
+            << row.average << '\t' << row.dispersion << '\n';
+    }
+    return 0;
+}
+}
 
 int main(int argc, char *argv[])
 {
+    // DATAANALYS_TRACE=<файл>: запись трассировки в формате Chrome trace при выходе
+    Tracing::enableFromEnvironment();
+    // DATAANALYS_ALLOC_STATS=1: учет памяти по этапам, панель по F12
+    AllocationStats::enableFromEnvironment();
+
+    // --study <N>: оценка эффективности оценок по N повторениям без запуска интерфейса
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (QString(argv[i]) == "--study")
+        {
+            QCoreApplication a(argc, argv);
+            return runEfficiencyStudy(QString(argv[i + 1]).toInt());
+        }
+    }
+
+    // --rolling <w> <файл>: характеристики по скользящему окну из w отсчетов ряда из файла
+    for (int i = 1; i + 2 < argc; i++)
+    {
+        if (QString(argv[i]) == "--rolling")
+        {
+            QCoreApplication a(argc, argv);
+            return runRollingStatistics(QString(argv[i + 1]).toInt(), QString::fromLocal8Bit(argv[i + 2]));
+        }
+    }
+
+    // --virtual: ряды порождаются по запросу без файлов
     QApplication a(argc, argv);
-    Widget w;
+    Widget w(nullptr, a.arguments().contains("--virtual"));
+    AllocationPanel::install(&w);
     w.show();
     return a.exec();
 }
@@ -0,0 +1,127 @@
+#include "rollingstatistics.h"
+
+#include <cmath>
+#include <iterator>
+
+RollingStatistics::RollingStatistics(int window) :
+    _buffer(std::max(window, 1), 0.0)
+{
+}
+
+void RollingStatistics::push(double value)
+{
+    // NaN не упорядочивается, его нельзя найти в половинах окна при вытеснении
+    if (std::isnan(value))
+        return;
+
+    if (isFull())
+    {
+        double oldest = _buffer[_head];
+        eraseOrdered(oldest);
+
+        if (_count > 1)
+        {
+            double delta = oldest - _mean;
+            _mean -= delta / (_count - 1);
+            _m2 -= delta * (oldest - _mean);
+        }
+        else
+        {
+            _mean = 0.0;
+            _m2 = 0.0;
+        }
+        _count--;
+        _evictions++;
+    }
+
+    _buffer[_head] = value;
+    _head = (_head + 1) % window();
+    insertOrdered(value);
+
+    _count++;
+    double delta = value - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (value - _mean);
+
+    if (_evictions >= window())
+        recompute();
+}
+
+double RollingStatistics::standardDeviation() const
+{
+    return std::sqrt(dispersion());
+}
+
+LocationEstimates RollingStatistics::locationEstimates() const
+{
+    LocationEstimates result;
+    const int trim = CalcUnit::trimCount(_count);
+    if (_count == 0 || trim >= _count / 2)
+        return result;
+
+    result.expectedValue = _mean;
+    result.halfSum = (*_low.begin() + (_high.empty() ? *_low.rbegin() : *_high.rbegin())) / 2;
+    result.median = _low.size() > _high.size() ? *_low.rbegin() : (*_low.rbegin() + *_high.begin()) / 2.0;
+
+    // 2k < n, поэтому k наименьших лежат в меньшей половине, k наибольших - в большей.
+    // Суммируется середина окна: вычитание крайних из полной суммы теряет точность.
+    double trimmedSum = 0.0;
+    for (auto it = std::next(_low.begin(), trim); it != _low.end(); ++it)
+        trimmedSum += *it;
+    for (auto it = _high.begin(), last = std::prev(_high.end(), trim); it != last; ++it)
+        trimmedSum += *it;
+
+    result.average = trimmedSum / (_count - 2 * trim);
+    return result;
+}
+
+void RollingStatistics::insertOrdered(double value)
+{
+    if (_low.empty() || value <= *_low.rbegin())
+        _low.insert(value);
+    else
+        _high.insert(value);
+    rebalance();
+}
+
+void RollingStatistics::eraseOrdered(double value)
+{
+    auto it = _low.find(value);
+    if (it != _low.end())
+        _low.erase(it);
+    else
+        _high.erase(_high.find(value));
+    rebalance();
+}
+
+void RollingStatistics::rebalance()
+{
+    // В меньшей половине столько же элементов, сколько в большей, или на один больше
+    if (_low.size() > _high.size() + 1)
+    {
+        auto it = std::prev(_low.end());
+        _high.insert(*it);
+        _low.erase(it);
+    }
+    else if (_high.size() > _low.size())
+    {
+        auto it = _high.begin();
+        _low.insert(*it);
+        _high.erase(it);
+    }
+}
+
+void RollingStatistics::recompute()
+{
+    _evictions = 0;
+
+    int start = (_head - _count + window()) % window();
+    double sum = 0.0;
+    for (int i = 0; i < _count; i++)
+        sum += _buffer[(start + i) % window()];
+    _mean = sum / _count;
+
+    _m2 = 0.0;
+    for (int i = 0; i < _count; i++)
+        _m2 += std::pow(_buffer[(start + i) % window()] - _mean, 2);
+}
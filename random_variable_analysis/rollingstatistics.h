@@ -0,0 +1,58 @@
+#ifndef ROLLINGSTATISTICS_H
+#define ROLLINGSTATISTICS_H
+
+#include "calcunit.h"
+
+#include <set>
+#include <vector>
+
+/**
+ * @brief Характеристики по скользящему окну из последних window отсчетов.
+ * @details Среднее и дисперсия обновляются за O(1) (добавление и удаление
+ * по Уэлфорду, раз в window вытеснений пересчитываются точно, чтобы не
+ * накапливалась ошибка округления). Окно хранится двумя упорядоченными
+ * половинами с обновлением за O(log w): медиана берется с их границы, среднее
+ * с отбросом крайних членов суммируется по середине окна за O(w).
+ */
+class RollingStatistics
+{
+public:
+    explicit RollingStatistics(int window);
+
+    /// Добавить отсчет, при заполненном окне самый старый отсчет вытесняется. NaN пропускается.
+    void push(double value);
+
+    int size() const { return _count; }
+    int window() const { return static_cast<int>(_buffer.size()); }
+    bool isFull() const { return _count == window(); }
+
+    double expectedValue() const { return _mean; }
+    double dispersion() const { return _count > 1 ? _m2 / (_count - 1) : 0.0; }
+    double standardDeviation() const;
+
+    /**
+     * Оценки положения по текущему окну, те же, что в CalcUnit::locationEstimates.
+     * Пусто, если отбрасывается половина окна и больше, как в CalcUnit::calculateStatistics.
+     */
+    LocationEstimates locationEstimates() const;
+
+private:
+    void insertOrdered(double value);
+    void eraseOrdered(double value);
+    void rebalance();
+    void recompute();
+
+private:
+    std::vector<double> _buffer;
+    int _head = 0;
+    int _count = 0;
+    int _evictions = 0;
+
+    double _mean = 0.0;
+    double _m2 = 0.0;
+
+    std::multiset<double> _low;     ///< Меньшая половина окна
+    std::multiset<double> _high;    ///< Большая половина окна
+};
+
+#endif // ROLLINGSTATISTICS_H
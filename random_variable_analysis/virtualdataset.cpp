@@ -0,0 +1,96 @@
+#include "virtualdataset.h"
+
+#include <QtMath>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+using PhiloxBlock = std::array<quint32, 4>;
+
+/// Philox4x32-10 (Salmon et al., 2011): 128-битный счетчик, 64-битный ключ.
+PhiloxBlock philox(quint64 counter, quint64 seed)
+{
+    PhiloxBlock block = {static_cast<quint32>(counter), static_cast<quint32>(counter >> 32), 0, 0};
+    quint32 key0 = static_cast<quint32>(seed);
+    quint32 key1 = static_cast<quint32>(seed >> 32);
+
+    for (int round = 0; round < 10; round++)
+    {
+        quint64 product0 = static_cast<quint64>(0xD2511F53u) * block[0];
+        quint64 product1 = static_cast<quint64>(0xCD9E8D57u) * block[2];
+        block = {static_cast<quint32>(product1 >> 32) ^ block[1] ^ key0,
+                 static_cast<quint32>(product1),
+                 static_cast<quint32>(product0 >> 32) ^ block[3] ^ key1,
+                 static_cast<quint32>(product0)};
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+    return block;
+}
+
+/// 53 старших бита двух слов в [0, 1).
+double toUnit(quint32 high, quint32 low)
+{
+    quint64 bits = (static_cast<quint64>(high) << 32 | low) >> 11;
+    return bits * (1.0 / 9007199254740992.0);
+}
+
+double normilize(double value, int decimal)
+{
+    int scale = std::pow(10, decimal);
+    return std::round(value * scale) / scale;
+}
+}
+
+VirtualDataset::VirtualDataset(Generator generator, double first, double second,
+                               quint64 seed, qint64 size, double offset) :
+    _generator(generator),
+    _first(first),
+    _second(second),
+    _seed(seed),
+    _size(size),
+    _offset(offset)
+{
+}
+
+double VirtualDataset::at(qint64 index) const
+{
+    double value;
+    generate(index, index + 1, &value);
+    return value;
+}
+
+void VirtualDataset::generate(qint64 from, qint64 to, double *output) const
+{
+    for (qint64 i = from; i < to; i++)
+    {
+        auto block = philox(static_cast<quint64>(i), _seed);
+
+        double value;
+        if (_generator == Uniform)
+        {
+            value = _first + toUnit(block[0], block[1]) * (_second - _first);
+        }
+        else
+        {
+            // Преобразование Бокса-Мюллера, r1 в (0, 1] для логарифма.
+            double r1 = 1.0 - toUnit(block[0], block[1]);
+            double r2 = toUnit(block[2], block[3]);
+            double z = std::sqrt(-2.0 * std::log(r1)) * std::cos(2.0 * M_PI * r2);
+            value = _first + z * _second;
+        }
+        output[i - from] = _offset + normilize(value, 5);
+    }
+}
+
+QVector<double> VirtualDataset::slice(qint64 from, qint64 to) const
+{
+    from = std::max<qint64>(0, from);
+    to = std::min(to, _size);
+
+    QVector<double> result(static_cast<int>(std::max<qint64>(0, to - from)));
+    generate(from, from + result.size(), result.data());
+    return result;
+}
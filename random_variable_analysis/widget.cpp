@@ -1,9 +1,24 @@
 #include "widget.h"
 #include "calcunit.h"
+#include "backgroundtask.h"
+#include "tracing.h"
 #include <QTableWidget>
 #include <QVBoxLayout>
 #include <QHeaderView>
 
+namespace
+{
+const QVector<int> sampleSizes = {15, 30, 100, 1000};
+
+/// Строки таблицы для одного закона шума и коэффициента.
+struct TableBlock
+{
+    int firstRow;
+    int coeff;
+    bool isGauss;
+};
+}
+
 inline QString getDoubleString(double value)
 {
     if (value < std::numeric_limits<double>::epsilon())
@@ -11,9 +26,8 @@ inline QString getDoubleString(double value)
     return QString::number(value, 'g', 8);
 }
 
-Widget::Widget(QWidget *parent)
-    : QWidget(parent),
-    _unit(QSharedPointer<CalcUnit>::create())
+Widget::Widget(QWidget *parent, bool virtualData)
+    : QWidget(parent)
 {
     resize(1500, 800);
 
@@ -39,11 +53,22 @@ Widget::Widget(QWidget *parent)
                                                         << "Дисперсия"
                                                         << "СКО");
 
-    addDataToTable(tableWidget, 20, true);
-    addDataToTable(tableWidget, 100, true);
-    addDataToTable(tableWidget, 20, false);
-    addDataToTable(tableWidget, 100, false);
+    // Строки добавляются сразу, оценки считаются в фоне и дописываются по готовности.
+    // Выборки читаются или порождаются при создании расчетника, поэтому он тоже создается в фоне.
+    QVector<TableBlock> blocks;
+    for (bool isGauss : {true, false})
+    {
+        for (int coeff : {20, 100})
+            blocks.append({addDataToTable(tableWidget, coeff, isGauss), coeff, isGauss});
+    }
 
+    runInBackground(this, [virtualData]() { return QSharedPointer<CalcUnit>::create(15, virtualData); },
+                    [this, tableWidget, blocks](const QSharedPointer<CalcUnit> &unit)
+    {
+        _unit = unit;
+        for (const auto &block : blocks)
+            calculateRows(tableWidget, block.firstRow, block.coeff, block.isGauss);
+    });
 
     auto layout = new QVBoxLayout(this);
     layout->addWidget(tableWidget);
@@ -54,8 +79,9 @@ Widget::~Widget()
 {
 }
 
-void Widget::addDataToTable(QTableWidget *table, int coeff, bool isGauss)
+int Widget::addDataToTable(QTableWidget *table, int coeff, bool isGauss)
 {
+    TRACE_SPAN("Widget::addDataToTable");
     auto nameRow = table->rowCount();
     table->insertRow(table->rowCount());
     table->insertRow(table->rowCount());
@@ -74,31 +100,52 @@ void Widget::addDataToTable(QTableWidget *table, int coeff, bool isGauss)
     table->setSpan(nameRow, 0, 2, table->columnCount());
     table->setItem(nameRow, 0, item);
 
-    QVector<int> sampleSizes = {15, 30, 100, 1000};
-
+    int firstRow = table->rowCount();
     for (const auto& sampleSize : sampleSizes)
     {
         int row = table->rowCount();
         table->insertRow(row);
-
-        QVector<double> data;
-        isGauss ? data = _unit->gaussElements(sampleSize, coeff)
-                : data = _unit->uniformElements(sampleSize, coeff);
-
-        auto statistic = _unit->calculateStatistics(data);
-
         addCenteredItem(QString::number(sampleSize), "", table,  row, 0);
-        addCenteredItem(getDoubleString(statistic.expectedValue), "Математическое ожидание", table,  row, 1);
-        addCenteredItem(getDoubleString(statistic.halfSum), "Полусумма крайних членов", table,  row, 2);
-        addCenteredItem(getDoubleString(statistic.median), "Медиана", table,  row, 3);
-        addCenteredItem(getDoubleString(statistic.average), "Среднее арифметическое с отбросом крайних членов", table,  row, 4);
-        addCenteredItem(getDoubleString(statistic.expectedValueDelta), "Дельта математического ожидания", table,  row, 5);
-        addCenteredItem(getDoubleString(statistic.halfSumDelta), "Дельта полусуммы крайних членов", table,  row, 6);
-        addCenteredItem(getDoubleString(statistic.medianDelta), "Дельта медианы", table,  row, 7);
-        addCenteredItem(getDoubleString(statistic.averageDelta), "Дельта среднего арифметическое с отбросом крайних членов", table,  row, 8);
-        addCenteredItem(getDoubleString(statistic.dispersion), "Дисперсия", table,  row, 9);
-        addCenteredItem(getDoubleString(statistic.standardDeviation), "Среднее квадратическое отклонение", table,  row, 10);
+        addCenteredItem("...", "Вычисление", table,  row, 1);
     }
+    return firstRow;
+}
+
+void Widget::calculateRows(QTableWidget *table, int firstRow, int coeff, bool isGauss)
+{
+    auto unit = _unit;
+    runInBackground(this, [unit, coeff, isGauss]()
+    {
+        QVector<Statistics> statistics;
+        for (const auto& sampleSize : sampleSizes)
+        {
+            QVector<double> data;
+            isGauss ? data = unit->gaussElements(sampleSize, coeff)
+                    : data = unit->uniformElements(sampleSize, coeff);
+
+            statistics.append(unit->calculateStatistics(data));
+        }
+        return statistics;
+    },
+    [this, table, firstRow](const QVector<Statistics> &statistics)
+    {
+        for (int i = 0; i < statistics.size(); i++)
+        {
+            int row = firstRow + i;
+            const auto &statistic = statistics[i];
+
+            addCenteredItem(getDoubleString(statistic.expectedValue), "Математическое ожидание", table,  row, 1);
+            addCenteredItem(getDoubleString(statistic.halfSum), "Полусумма крайних членов", table,  row, 2);
+            addCenteredItem(getDoubleString(statistic.median), "Медиана", table,  row, 3);
+            addCenteredItem(getDoubleString(statistic.average), "Среднее арифметическое с отбросом крайних членов", table,  row, 4);
+            addCenteredItem(getDoubleString(statistic.expectedValueDelta), "Дельта математического ожидания", table,  row, 5);
+            addCenteredItem(getDoubleString(statistic.halfSumDelta), "Дельта полусуммы крайних членов", table,  row, 6);
+            addCenteredItem(getDoubleString(statistic.medianDelta), "Дельта медианы", table,  row, 7);
+            addCenteredItem(getDoubleString(statistic.averageDelta), "Дельта среднего арифметическое с отбросом крайних членов", table,  row, 8);
+            addCenteredItem(getDoubleString(statistic.dispersion), "Дисперсия", table,  row, 9);
+            addCenteredItem(getDoubleString(statistic.standardDeviation), "Среднее квадратическое отклонение", table,  row, 10);
+        }
+    });
 }
 
 void Widget::addCenteredItem(const QString &text, const QString &tooltip, QTableWidget *widget, int row, int column)
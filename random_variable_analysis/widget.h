@@ -11,11 +11,14 @@ class Widget : public QWidget
     Q_OBJECT
 
 public:
-    Widget(QWidget *parent = nullptr);
+    Widget(QWidget *parent = nullptr, bool virtualData = false);
     ~Widget();
 
 private:
-    void addDataToTable(QTableWidget * table, int coeff, bool isGauss);
+    /// Добавляет заголовок и строки объемов выборки, возвращает номер первой строки.
+    int addDataToTable(QTableWidget * table, int coeff, bool isGauss);
+    /// Считает оценки в фоне и заполняет строки, начиная с firstRow.
+    void calculateRows(QTableWidget *table, int firstRow, int coeff, bool isGauss);
     void addCenteredItem(const QString &text,
                          const QString &tooltip,
                          QTableWidget *widget,